@@ -0,0 +1,211 @@
+// benchmark.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "sparse.h"
+
+// Every kernel is repeated until it has run for at least BENCH_MIN_TIME seconds
+#define BENCH_MIN_TIME 0.05
+#define BENCH_SEED 2024
+#define BENCH_MAX_SIZE 2000       // largest n for SpMV (default, first argument overrides)
+#define BENCH_GEMM_MAX_SIZE 1000  // largest n for SpGEMM and the dense product (second argument)
+
+static const int bench_sizes[] = {250, 500, 1000, 2000, 4000, 8000};
+static const double bench_fills[] = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.3, 0.5, 0.7};
+#define N_SIZES (int)(sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+#define N_FILLS (int)(sizeof(bench_fills) / sizeof(bench_fills[0]))
+
+typedef struct {
+    const CsrMatrix* A;
+    const double* dense;
+    const double* x;
+    double* y;
+    double* C_dense;
+} BenchData;
+
+typedef void (*Kernel)(BenchData* data);
+
+static void csr_spmv_kernel(BenchData* data) {
+    csr_spmv(data->A, data->x, data->y);
+}
+
+static void dense_matvec_kernel(BenchData* data) {
+    dense_matvec(data->A->n_rows, data->A->n_cols, data->dense, data->x, data->y);
+}
+
+static void spgemm_kernel(BenchData* data) {
+    CsrMatrix C;
+    if (csr_spgemm(data->A, data->A, &C, NULL) == 0) {
+        free_csr(&C);
+    }
+}
+
+static void dense_matmul_kernel(BenchData* data) {
+    int n = data->A->n_rows;
+    dense_matmul(n, n, n, data->dense, data->dense, data->C_dense);
+}
+
+static double wall_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+// Seconds per call of the kernel: one warm-up call, then doubling repetitions until the
+// measurement lasts BENCH_MIN_TIME (a warm-up that long is the measurement)
+static double time_kernel(Kernel kernel, BenchData* data) {
+    double start = wall_time();
+    kernel(data);
+    double elapsed = wall_time() - start;
+    if (elapsed >= BENCH_MIN_TIME) {
+        return elapsed;
+    }
+    for (int repetitions = 1; ; repetitions *= 2) {
+        start = wall_time();
+        for (int r = 0; r < repetitions; r++) {
+            kernel(data);
+        }
+        elapsed = wall_time() - start;
+        if (elapsed >= BENCH_MIN_TIME) {
+            return elapsed / repetitions;
+        }
+    }
+}
+
+// Writes one timing as {"seconds", "gflops", "gbytes_per_s"} from the flops and bytes of a call
+static void print_timing(FILE* out, const char* name, double seconds, double flops, double bytes, int last) {
+    fprintf(out, "\"%s\": {\"seconds\": %.6e, \"gflops\": %.4f, \"gbytes_per_s\": %.4f}%s", name, seconds,
+            flops / seconds * 1e-9, bytes / seconds * 1e-9, last ? "" : ", ");
+}
+
+// Fill at which the dense time drops to the sparse time, interpolated in log(fill) between the
+// two measured fills around the crossing. Returns -1 if dense never wins, the smallest fill if it
+// always wins.
+static double crossover_fill(const double* sparse_time, const double* dense_time, int n_fills) {
+    for (int f = 0; f < n_fills; f++) {
+        if (sparse_time[f] <= 0.0 || dense_time[f] <= 0.0) continue;
+        if (dense_time[f] <= sparse_time[f]) {
+            if (f == 0 || sparse_time[f - 1] <= 0.0 || dense_time[f - 1] <= 0.0) {
+                return bench_fills[f];
+            }
+            double r0 = log(dense_time[f - 1] / sparse_time[f - 1]);
+            double r1 = log(dense_time[f] / sparse_time[f]);
+            double t = r0 / (r0 - r1);
+            return exp(log(bench_fills[f - 1]) + t * (log(bench_fills[f]) - log(bench_fills[f - 1])));
+        }
+    }
+    return -1.0;
+}
+
+static void print_fill(FILE* out, const char* name, double fill, int last) {
+    if (fill < 0.0) fprintf(out, "\"%s\": null%s", name, last ? "" : ", ");
+    else fprintf(out, "\"%s\": %.4f%s", name, fill, last ? "" : ", ");
+}
+
+// Benchmark of dense and sparse products on random n x n matrices (all entries, not only the
+// upper triangle) over the fills in bench_fills, written as JSON to the file given as first
+// argument (stdout if missing or "-"). The optional second and third arguments are the largest
+// sizes for SpMV and for the matrix-matrix products.
+int main(int argc, char* argv[]) {
+    FILE* out = stdout;
+    if (argc > 1 && strcmp(argv[1], "-") != 0) {
+        out = fopen(argv[1], "w");
+        if (out == NULL) {
+            fprintf(stderr, "Error opening file '%s' for writing\n", argv[1]);
+            return 1;
+        }
+    }
+    int max_size = argc > 2 ? atoi(argv[2]) : BENCH_MAX_SIZE;
+    int gemm_max_size = argc > 3 ? atoi(argv[3]) : BENCH_GEMM_MAX_SIZE;
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+
+    fprintf(out, "{\n  \"threads\": %d, \"seed\": %d, \"min_time\": %g,\n  \"results\": [", nthreads, BENCH_SEED, BENCH_MIN_TIME);
+    double spmv_time[N_SIZES][2][N_FILLS];
+    double gemm_time[N_SIZES][2][N_FILLS];
+    memset(spmv_time, 0, sizeof(spmv_time));
+    memset(gemm_time, 0, sizeof(gemm_time));
+    int first_result = 1;
+    for (int s = 0; s < N_SIZES && bench_sizes[s] <= max_size; s++) {
+        int n = bench_sizes[s];
+        double* x = malloc((size_t)n * sizeof(double));
+        double* y = malloc((size_t)n * sizeof(double));
+        double* C_dense = n <= gemm_max_size ? malloc((size_t)n * n * sizeof(double)) : NULL;
+        if (x == NULL || y == NULL || (n <= gemm_max_size && C_dense == NULL)) {
+            fprintf(stderr, "Memory allocation failed for vectors.\n");
+            return 1;
+        }
+        for (int j = 0; j < n; j++) {
+            x[j] = 1.0 + (double)j / n;
+        }
+        for (int f = 0; f < N_FILLS; f++) {
+            CsrMatrix A;
+            if (random_csr(n, bench_fills[f], BENCH_SEED + s, 0, &A) != 0) {
+                return 1;
+            }
+            double* dense = csr_to_dense(&A);
+            if (dense == NULL) {
+                return 1;
+            }
+            BenchData data = {&A, dense, x, y, C_dense};
+            fprintf(stderr, "n = %d, fill = %g\n", n, bench_fills[f]);
+
+            double nnz = (double)A.nnz;
+            double nn = (double)n * n;
+            double t_csr = time_kernel(csr_spmv_kernel, &data);
+            double t_dense = time_kernel(dense_matvec_kernel, &data);
+            spmv_time[s][0][f] = t_csr;
+            spmv_time[s][1][f] = t_dense;
+            fprintf(out, "%s\n    {\"n\": %d, \"fill\": %g, \"nnz\": %zu,\n     \"spmv\": {", first_result ? "" : ",",
+                    n, bench_fills[f], A.nnz);
+            first_result = 0;
+            print_timing(out, "csr", t_csr, 2.0 * nnz, 12.0 * nnz + 8.0 * (n + 1) + 16.0 * n, 0);
+            print_timing(out, "dense", t_dense, 2.0 * nn, 8.0 * nn + 16.0 * n, 1);
+            fprintf(out, "}");
+
+            if (n <= gemm_max_size) {
+                CsrMatrix C;
+                size_t n_mult;
+                if (csr_spgemm(&A, &A, &C, &n_mult) != 0) {
+                    return 1;
+                }
+                double t_spgemm = time_kernel(spgemm_kernel, &data);
+                double t_matmul = time_kernel(dense_matmul_kernel, &data);
+                gemm_time[s][0][f] = t_spgemm;
+                gemm_time[s][1][f] = t_matmul;
+                fprintf(out, ",\n     \"spgemm\": {\"multiplications\": %zu, \"nnz_product\": %zu, ", n_mult, C.nnz);
+                print_timing(out, "csr", t_spgemm, 2.0 * n_mult, 24.0 * nnz + 12.0 * C.nnz + 16.0 * (n + 1), 0);
+                print_timing(out, "dense", t_matmul, 2.0 * nn * n, 24.0 * nn, 1);
+                fprintf(out, "}");
+                free_csr(&C);
+            }
+            fprintf(out, "}");
+            free(dense);
+            free_csr(&A);
+        }
+        free(x);
+        free(y);
+        free(C_dense);
+    }
+
+    fprintf(out, "\n  ],\n  \"crossover_fill\": [");
+    for (int s = 0; s < N_SIZES && bench_sizes[s] <= max_size; s++) {
+        fprintf(out, "%s\n    {\"n\": %d, ", s == 0 ? "" : ",", bench_sizes[s]);
+        print_fill(out, "spmv", crossover_fill(spmv_time[s][0], spmv_time[s][1], N_FILLS), bench_sizes[s] > gemm_max_size);
+        if (bench_sizes[s] <= gemm_max_size) {
+            print_fill(out, "spgemm", crossover_fill(gemm_time[s][0], gemm_time[s][1], N_FILLS), 1);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,498 @@
+// format.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sparse.h"
+
+// SELL-C-sigma only pays off when the slice loop is vectorised with gathers of x, which needs
+// AVX2 or AVX-512 (e.g. make CFLAGS="-O2 -Wall -fopenmp -march=native"). Without them it is
+// slower than CSR, so the automatic choice skips it.
+#if defined(__AVX2__) || defined(__AVX512F__)
+#define SELL_HAS_GATHER 1
+#else
+#define SELL_HAS_GATHER 0
+#endif
+
+static const char* format_names[] = {"auto", "csr", "sell", "bcsr", "dense"};
+
+const char* format_name(MatrixFormat format) {
+    return format_names[format];
+}
+
+// Function to translate a format name ("auto", "csr", "sell", "bcsr" or "dense")
+int parse_format(const char* name, MatrixFormat* format) {
+    for (int f = FORMAT_AUTO; f <= FORMAT_DENSE; f++) {
+        if (strcmp(name, format_names[f]) == 0) {
+            *format = (MatrixFormat)f;
+            return 0;
+        }
+    }
+    fprintf(stderr, "Error: unknown matrix format '%s' (auto, csr, sell, bcsr or dense)\n", name);
+    return 1;
+}
+
+// Sorts the rows first .. first+count-1 by decreasing length into order (insertion sort, stable)
+static void sort_rows_by_length(const CsrMatrix* A, int first, int count, int* order) {
+    for (int r = 0; r < count; r++) {
+        int i = first + r;
+        size_t length = A->row_ptr[i + 1] - A->row_ptr[i];
+        int pos = r;
+        while (pos > 0 && A->row_ptr[order[pos - 1] + 1] - A->row_ptr[order[pos - 1]] < length) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+}
+
+// Function to convert a CSR matrix to SELL-C-sigma format
+// Padding entries repeat the last column of their row (column 0 for empty rows) with value 0.
+int csr_to_sell(const CsrMatrix* A, SellMatrix* B) {
+    memset(B, 0, sizeof(SellMatrix));
+    B->n_rows = A->n_rows;
+    B->n_cols = A->n_cols;
+    B->n_slices = (A->n_rows + SELL_CHUNK - 1) / SELL_CHUNK;
+    size_t n_slots = (size_t)B->n_slices * SELL_CHUNK;
+    B->slice_ptr = calloc((size_t)B->n_slices + 1, sizeof(size_t));
+    B->slice_width = calloc((size_t)B->n_slices + 1, sizeof(int));
+    B->row = malloc(n_slots * sizeof(int));
+    if (B->slice_ptr == NULL || B->slice_width == NULL || B->row == NULL) {
+        fprintf(stderr, "Memory allocation failed for SELL matrix.\n");
+        free_sell(B);
+        return 1;
+    }
+    for (int first = 0; first < A->n_rows; first += SELL_SIGMA) {
+        int count = A->n_rows - first < SELL_SIGMA ? A->n_rows - first : SELL_SIGMA;
+        sort_rows_by_length(A, first, count, B->row + first);
+    }
+    for (size_t r = (size_t)A->n_rows; r < n_slots; r++) {
+        B->row[r] = -1;
+    }
+    for (int s = 0; s < B->n_slices; s++) {
+        int i = B->row[(size_t)s * SELL_CHUNK]; // longest row of the slice comes first
+        B->slice_width[s] = (int)(A->row_ptr[i + 1] - A->row_ptr[i]);
+        B->slice_ptr[s + 1] = B->slice_ptr[s] + (size_t)B->slice_width[s] * SELL_CHUNK;
+    }
+    B->nnz = B->slice_ptr[B->n_slices];
+    B->col_idx = malloc((B->nnz > 0 ? B->nnz : 1) * sizeof(int));
+    B->val = malloc((B->nnz > 0 ? B->nnz : 1) * sizeof(double));
+    if (B->col_idx == NULL || B->val == NULL) {
+        fprintf(stderr, "Memory allocation failed for SELL matrix.\n");
+        free_sell(B);
+        return 1;
+    }
+    for (int s = 0; s < B->n_slices; s++) {
+        for (int r = 0; r < SELL_CHUNK; r++) {
+            int i = B->row[(size_t)s * SELL_CHUNK + r];
+            size_t start = i >= 0 ? A->row_ptr[i] : 0;
+            size_t length = i >= 0 ? A->row_ptr[i + 1] - start : 0;
+            for (int k = 0; k < B->slice_width[s]; k++) {
+                size_t pos = B->slice_ptr[s] + (size_t)k * SELL_CHUNK + r;
+                if ((size_t)k < length) {
+                    B->col_idx[pos] = A->col_idx[start + k];
+                    B->val[pos] = A->val[start + k];
+                }
+                else {
+                    B->col_idx[pos] = length > 0 ? A->col_idx[start + length - 1] : 0;
+                    B->val[pos] = 0.0;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Function to calculate y = A x for a SELL-C-sigma matrix
+// The SELL_CHUNK rows of a slice are processed together, so the inner loop runs over
+// consecutive entries and vectorises. Slices are handed out dynamically since their widths differ.
+void sell_spmv(const SellMatrix* A, const double* x, double* y) {
+    #pragma omp parallel for schedule(dynamic, 32)
+    for (int s = 0; s < A->n_slices; s++) {
+        double sum[SELL_CHUNK] = {0.0};
+        const int* col = A->col_idx + A->slice_ptr[s];
+        const double* val = A->val + A->slice_ptr[s];
+        for (int k = 0; k < A->slice_width[s]; k++) {
+            #pragma omp simd
+            for (int r = 0; r < SELL_CHUNK; r++) {
+                sum[r] += val[k * SELL_CHUNK + r] * x[col[k * SELL_CHUNK + r]];
+            }
+        }
+        const int* row = A->row + (size_t)s * SELL_CHUNK;
+        for (int r = 0; r < SELL_CHUNK; r++) {
+            if (row[r] >= 0) y[row[r]] = sum[r];
+        }
+    }
+}
+
+// Function to convert a CSR matrix to block-CSR format with BCSR_BLOCK x BCSR_BLOCK blocks
+// Blocks at the right and bottom edges are padded with zeros.
+int csr_to_bcsr(const CsrMatrix* A, BcsrMatrix* B) {
+    memset(B, 0, sizeof(BcsrMatrix));
+    B->n_rows = A->n_rows;
+    B->n_cols = A->n_cols;
+    B->n_block_rows = (A->n_rows + BCSR_BLOCK - 1) / BCSR_BLOCK;
+    int n_block_cols = (A->n_cols + BCSR_BLOCK - 1) / BCSR_BLOCK;
+    B->block_ptr = calloc((size_t)B->n_block_rows + 1, sizeof(size_t));
+    int* slot = malloc((size_t)n_block_cols * sizeof(int));
+    if (B->block_ptr == NULL || slot == NULL) {
+        fprintf(stderr, "Memory allocation failed for block-CSR matrix.\n");
+        free(slot);
+        free_bcsr(B);
+        return 1;
+    }
+
+    // First pass counts the distinct block columns of every block row, the second fills the blocks.
+    // slot[bc] is the position of block column bc in the current block row (-1 if not present).
+    for (int bc = 0; bc < n_block_cols; bc++) {
+        slot[bc] = -1;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        for (int br = 0; br < B->n_block_rows; br++) {
+            int first = br * BCSR_BLOCK;
+            int last = first + BCSR_BLOCK < A->n_rows ? first + BCSR_BLOCK : A->n_rows;
+            size_t count = 0;
+            // Block columns are numbered in order of first appearance, sorted in the second pass
+            for (int i = first; i < last; i++) {
+                for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+                    int bc = A->col_idx[k] / BCSR_BLOCK;
+                    if (slot[bc] < 0) {
+                        slot[bc] = (int)count++;
+                        if (pass == 1) B->block_col[B->block_ptr[br] + slot[bc]] = bc;
+                    }
+                }
+            }
+            if (pass == 0) {
+                B->block_ptr[br + 1] = B->block_ptr[br] + count;
+            }
+            else {
+                // Sort the block columns (insertion sort, blocks per block row are few) and refill
+                int* cols = B->block_col + B->block_ptr[br];
+                for (size_t a = 1; a < count; a++) {
+                    int c = cols[a];
+                    size_t pos = a;
+                    while (pos > 0 && cols[pos - 1] > c) {
+                        cols[pos] = cols[pos - 1];
+                        pos--;
+                    }
+                    cols[pos] = c;
+                }
+                for (size_t a = 0; a < count; a++) {
+                    slot[cols[a]] = (int)a;
+                }
+                double* blocks = B->val + B->block_ptr[br] * BCSR_BLOCK * BCSR_BLOCK;
+                for (int i = first; i < last; i++) {
+                    for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+                        int j = A->col_idx[k];
+                        blocks[(size_t)slot[j / BCSR_BLOCK] * BCSR_BLOCK * BCSR_BLOCK + (i - first) * BCSR_BLOCK + j % BCSR_BLOCK] = A->val[k];
+                    }
+                }
+            }
+            for (int i = first; i < last; i++) {
+                for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+                    slot[A->col_idx[k] / BCSR_BLOCK] = -1;
+                }
+            }
+        }
+        if (pass == 0) {
+            B->n_blocks = B->block_ptr[B->n_block_rows];
+            B->block_col = malloc((B->n_blocks > 0 ? B->n_blocks : 1) * sizeof(int));
+            B->val = calloc((B->n_blocks > 0 ? B->n_blocks : 1) * BCSR_BLOCK * BCSR_BLOCK, sizeof(double));
+            if (B->block_col == NULL || B->val == NULL) {
+                fprintf(stderr, "Memory allocation failed for block-CSR matrix.\n");
+                free(slot);
+                free_bcsr(B);
+                return 1;
+            }
+        }
+    }
+    free(slot);
+    return 0;
+}
+
+// Function to calculate y = A x for a block-CSR matrix
+// Every block is a small dense matrix-vector product with no index lookups inside the block.
+// Only blocks at the right edge need the column check.
+void bcsr_spmv(const BcsrMatrix* A, const double* x, double* y) {
+    int full_cols = A->n_cols / BCSR_BLOCK;
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int br = 0; br < A->n_block_rows; br++) {
+        double sum[BCSR_BLOCK] = {0.0};
+        for (size_t b = A->block_ptr[br]; b < A->block_ptr[br + 1]; b++) {
+            const double* block = A->val + b * BCSR_BLOCK * BCSR_BLOCK;
+            int j0 = A->block_col[b] * BCSR_BLOCK;
+            if (A->block_col[b] < full_cols) {
+                for (int r = 0; r < BCSR_BLOCK; r++) {
+                    for (int c = 0; c < BCSR_BLOCK; c++) {
+                        sum[r] += block[r * BCSR_BLOCK + c] * x[j0 + c];
+                    }
+                }
+            }
+            else {
+                for (int r = 0; r < BCSR_BLOCK; r++) {
+                    for (int c = 0; j0 + c < A->n_cols; c++) {
+                        sum[r] += block[r * BCSR_BLOCK + c] * x[j0 + c];
+                    }
+                }
+            }
+        }
+        for (int r = 0; r < BCSR_BLOCK && br * BCSR_BLOCK + r < A->n_rows; r++) {
+            y[br * BCSR_BLOCK + r] = sum[r];
+        }
+    }
+}
+
+// Function to convert a dense row-major matrix to CSR format, keeping the nonzero entries
+int dense_to_csr(int n_rows, int n_cols, const double* D, CsrMatrix* A) {
+    memset(A, 0, sizeof(CsrMatrix));
+    A->n_rows = n_rows;
+    A->n_cols = n_cols;
+    A->row_ptr = calloc((size_t)n_rows + 1, sizeof(size_t));
+    if (A->row_ptr == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+        return 1;
+    }
+    for (int i = 0; i < n_rows; i++) {
+        size_t count = 0;
+        for (int j = 0; j < n_cols; j++) {
+            count += D[(size_t)i * n_cols + j] != 0.0;
+        }
+        A->row_ptr[i + 1] = A->row_ptr[i] + count;
+    }
+    A->nnz = A->row_ptr[n_rows];
+    A->col_idx = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(int));
+    A->val = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(double));
+    if (A->col_idx == NULL || A->val == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+        free_csr(A);
+        return 1;
+    }
+    size_t out = 0;
+    for (int i = 0; i < n_rows; i++) {
+        for (int j = 0; j < n_cols; j++) {
+            double value = D[(size_t)i * n_cols + j];
+            if (value != 0.0) {
+                A->col_idx[out] = j;
+                A->val[out++] = value;
+            }
+        }
+    }
+    A->fill = (double)A->nnz / ((double)n_rows * n_cols);
+    return 0;
+}
+
+void free_sell(SellMatrix* A) {
+    free(A->slice_ptr);
+    free(A->slice_width);
+    free(A->row);
+    free(A->col_idx);
+    free(A->val);
+    memset(A, 0, sizeof(SellMatrix));
+}
+
+void free_bcsr(BcsrMatrix* A) {
+    free(A->block_ptr);
+    free(A->block_col);
+    free(A->val);
+    memset(A, 0, sizeof(BcsrMatrix));
+}
+
+// Stored entries of A in SELL-C-sigma format (without building it)
+static size_t sell_entries(const CsrMatrix* A) {
+    size_t entries = 0;
+    int* order = malloc(SELL_SIGMA * sizeof(int));
+    if (order == NULL) {
+        return (size_t)-1;
+    }
+    for (int first = 0; first < A->n_rows; first += SELL_SIGMA) {
+        int count = A->n_rows - first < SELL_SIGMA ? A->n_rows - first : SELL_SIGMA;
+        sort_rows_by_length(A, first, count, order);
+        for (int r = 0; r < count; r += SELL_CHUNK) {
+            entries += (A->row_ptr[order[r] + 1] - A->row_ptr[order[r]]) * SELL_CHUNK;
+        }
+    }
+    free(order);
+    return entries;
+}
+
+// Number of nonzero BCSR_BLOCK x BCSR_BLOCK blocks of A (without building the block matrix)
+static size_t bcsr_blocks(const CsrMatrix* A) {
+    int n_block_cols = (A->n_cols + BCSR_BLOCK - 1) / BCSR_BLOCK;
+    int* seen = malloc((size_t)n_block_cols * sizeof(int));
+    if (seen == NULL) {
+        return (size_t)-1;
+    }
+    for (int bc = 0; bc < n_block_cols; bc++) {
+        seen[bc] = -1;
+    }
+    size_t blocks = 0;
+    for (int i = 0; i < A->n_rows; i++) {
+        int br = i / BCSR_BLOCK;
+        for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            int bc = A->col_idx[k] / BCSR_BLOCK;
+            if (seen[bc] != br) {
+                seen[bc] = br;
+                blocks++;
+            }
+        }
+    }
+    free(seen);
+    return blocks;
+}
+
+// Chooses the SpMV format of A from its fill and row-length distribution, in this order:
+//   dense      if the fill is at least FORMAT_DENSE_FILL and the matrix is small enough
+//   block-CSR  if the nonzero blocks are on average at least FORMAT_BCSR_MIN_BLOCK_FILL full
+//   SELL-C-σ   if the rows are long enough, padding them costs little (similar row lengths) and
+//              the build has SIMD gathers
+//   CSR        otherwise
+static void choose_spmv_format(const CsrMatrix* A, FormatChoice* choice) {
+    double entries = (double)A->n_rows * A->n_cols;
+    double fill = A->nnz / entries;
+    double mean_row = (double)A->nnz / A->n_rows;
+    if (fill >= FORMAT_DENSE_FILL && entries <= FORMAT_DENSE_MAX_ENTRIES) {
+        choice->format = FORMAT_DENSE;
+        snprintf(choice->reason, sizeof(choice->reason), "fill %.4f >= %.2f, dense rows stream without indices",
+                 fill, FORMAT_DENSE_FILL);
+        return;
+    }
+    size_t blocks = bcsr_blocks(A);
+    double block_fill = blocks > 0 && blocks != (size_t)-1 ? (double)A->nnz / ((double)blocks * BCSR_BLOCK * BCSR_BLOCK) : 0.0;
+    if (block_fill >= FORMAT_BCSR_MIN_BLOCK_FILL) {
+        choice->format = FORMAT_BCSR;
+        snprintf(choice->reason, sizeof(choice->reason), "fill %.4f, %dx%d blocks %.2f full on average (>= %.2f)",
+                 fill, BCSR_BLOCK, BCSR_BLOCK, block_fill, FORMAT_BCSR_MIN_BLOCK_FILL);
+        return;
+    }
+    size_t stored = sell_entries(A);
+    double padding = A->nnz > 0 && stored != (size_t)-1 ? (double)stored / A->nnz : 0.0;
+    int sell_fits = mean_row >= FORMAT_SELL_MIN_ROW && padding > 0.0 && padding <= FORMAT_SELL_MAX_PADDING;
+    if (sell_fits && SELL_HAS_GATHER) {
+        choice->format = FORMAT_SELL;
+        snprintf(choice->reason, sizeof(choice->reason),
+                 "fill %.4f, mean row length %.1f, SELL-%d-%d padding %.2f (<= %.2f)",
+                 fill, mean_row, SELL_CHUNK, SELL_SIGMA, padding, FORMAT_SELL_MAX_PADDING);
+        return;
+    }
+    choice->format = FORMAT_CSR;
+    snprintf(choice->reason, sizeof(choice->reason),
+             "fill %.4f < %.2f, block fill %.2f, mean row length %.1f, SELL padding %.2f%s",
+             fill, FORMAT_DENSE_FILL, block_fill, mean_row, padding,
+             sell_fits ? " (SELL would fit but this build has no SIMD gathers)" : "");
+}
+
+// Function to prepare A for repeated SpMV in the requested format, or the automatically chosen
+// one for FORMAT_AUTO. A is kept by reference and must outlive M.
+int format_matrix(const CsrMatrix* A, MatrixFormat requested, FormattedMatrix* M) {
+    memset(M, 0, sizeof(FormattedMatrix));
+    M->csr = A;
+    if (requested == FORMAT_AUTO) {
+        choose_spmv_format(A, &M->choice);
+    }
+    else {
+        M->choice.format = requested;
+        snprintf(M->choice.reason, sizeof(M->choice.reason), "requested");
+    }
+    switch (M->choice.format) {
+    case FORMAT_SELL:
+        return csr_to_sell(A, &M->sell);
+    case FORMAT_BCSR:
+        return csr_to_bcsr(A, &M->bcsr);
+    case FORMAT_DENSE:
+        M->dense = csr_to_dense(A);
+        return M->dense == NULL;
+    default:
+        return 0;
+    }
+}
+
+void formatted_spmv(const FormattedMatrix* M, const double* x, double* y) {
+    switch (M->choice.format) {
+    case FORMAT_SELL:
+        sell_spmv(&M->sell, x, y);
+        break;
+    case FORMAT_BCSR:
+        bcsr_spmv(&M->bcsr, x, y);
+        break;
+    case FORMAT_DENSE:
+        dense_matvec(M->csr->n_rows, M->csr->n_cols, M->dense, x, y);
+        break;
+    default:
+        csr_spmv(M->csr, x, y);
+    }
+}
+
+void free_formatted(FormattedMatrix* M) {
+    free_sell(&M->sell);
+    free_bcsr(&M->bcsr);
+    free(M->dense);
+    M->dense = NULL;
+}
+
+// Function to calculate C = A B with CSR SpGEMM or a dense product, whichever fits
+// The sparse product costs one indexed update per multiplication, the dense product always does
+// all n m p multiply-adds but with contiguous, vectorised loops. From FORMAT_SPGEMM_DENSE_RATIO
+// multiplications per dense multiply-add on (and if the three dense matrices fit) the dense product
+// is faster despite the conversions. Only CSR and dense have a matrix-matrix product, other
+// requested formats fall back to CSR.
+int auto_spgemm(const CsrMatrix* A, const CsrMatrix* B, MatrixFormat requested, CsrMatrix* C, FormatChoice* choice) {
+    if (A->n_cols != B->n_rows) {
+        fprintf(stderr, "Error: cannot multiply a %d x %d matrix with a %d x %d matrix\n", A->n_rows, A->n_cols, B->n_rows, B->n_cols);
+        return 1;
+    }
+    size_t n_mult = 0;
+    for (size_t k = 0; k < A->nnz; k++) {
+        n_mult += B->row_ptr[A->col_idx[k] + 1] - B->row_ptr[A->col_idx[k]];
+    }
+    double dense_mult = (double)A->n_rows * A->n_cols * B->n_cols;
+    double largest = (double)A->n_rows * A->n_cols;
+    if ((double)B->n_rows * B->n_cols > largest) largest = (double)B->n_rows * B->n_cols;
+    if ((double)A->n_rows * B->n_cols > largest) largest = (double)A->n_rows * B->n_cols;
+
+    if (requested == FORMAT_AUTO) {
+        double ratio = dense_mult > 0.0 ? n_mult / dense_mult : 0.0;
+        if (ratio >= FORMAT_SPGEMM_DENSE_RATIO && largest <= FORMAT_DENSE_MAX_ENTRIES) {
+            choice->format = FORMAT_DENSE;
+            snprintf(choice->reason, sizeof(choice->reason), "multiplications %.3f of n m p (>= %.2f)",
+                     ratio, FORMAT_SPGEMM_DENSE_RATIO);
+        }
+        else {
+            choice->format = FORMAT_CSR;
+            snprintf(choice->reason, sizeof(choice->reason), "multiplications %.3f of n m p (< %.2f)%s",
+                     ratio, FORMAT_SPGEMM_DENSE_RATIO,
+                     largest > FORMAT_DENSE_MAX_ENTRIES ? " or too large for dense storage" : "");
+        }
+    }
+    else if (requested == FORMAT_DENSE) {
+        choice->format = FORMAT_DENSE;
+        snprintf(choice->reason, sizeof(choice->reason), "requested");
+    }
+    else if (requested == FORMAT_CSR) {
+        choice->format = FORMAT_CSR;
+        snprintf(choice->reason, sizeof(choice->reason), "requested");
+    }
+    else {
+        choice->format = FORMAT_CSR;
+        snprintf(choice->reason, sizeof(choice->reason), "requested %s, which has no matrix-matrix product",
+                 format_name(requested));
+    }
+
+    if (choice->format == FORMAT_CSR) {
+        return csr_spgemm(A, B, C, NULL);
+    }
+    double* A_dense = csr_to_dense(A);
+    double* B_dense = csr_to_dense(B);
+    double* C_dense = malloc((size_t)A->n_rows * B->n_cols * sizeof(double));
+    int rc = 1;
+    if (A_dense != NULL && B_dense != NULL && C_dense != NULL) {
+        dense_matmul(A->n_rows, A->n_cols, B->n_cols, A_dense, B_dense, C_dense);
+        rc = dense_to_csr(A->n_rows, B->n_cols, C_dense, C);
+    }
+    else {
+        fprintf(stderr, "Memory allocation failed for dense matrices.\n");
+    }
+    free(A_dense);
+    free(B_dense);
+    free(C_dense);
+    return rc;
+}
@@ -0,0 +1,146 @@
+// generate.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sparse.h"
+
+// splitmix64: every row gets its own stream derived from (seed, row), so the matrix depends only
+// on the seed and not on the number of threads or on whether it is written or kept in memory
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Uniform random number in [0, 1)
+static double random_uniform(uint64_t* state) {
+    return (splitmix64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint64_t row_stream(uint64_t seed, int i) {
+    uint64_t state = seed ^ ((uint64_t)i * 0xD1B54A32D192ED03ull);
+    splitmix64(&state);
+    return state;
+}
+
+// Entries of row i: every column j (j >= i if upper) is present with probability `fraction`, with
+// a value uniform in [0, 1) as in the data files. The gaps between present columns are geometric,
+// so a row costs O(entries) instead of O(n). Returns the number of entries, written to cols/vals
+// if they are not NULL.
+static size_t random_row(uint64_t seed, int i, int n, double fraction, int upper, int* cols, double* vals) {
+    uint64_t state = row_stream(seed, i);
+    double log_miss = fraction < 1.0 ? log1p(-fraction) : 0.0;
+    size_t count = 0;
+    long long j = (upper ? i : 0) - 1;
+    while (1) {
+        if (fraction < 1.0) {
+            double u = 1.0 - random_uniform(&state); // (0, 1]
+            double skip = floor(log(u) / log_miss);
+            if (skip >= (double)n) break;
+            j += 1 + (long long)skip;
+        }
+        else {
+            j++;
+        }
+        if (j >= n) break;
+        double value = random_uniform(&state);
+        if (cols != NULL) {
+            cols[count] = (int)j;
+            vals[count] = value;
+        }
+        count++;
+    }
+    return count;
+}
+
+static int check_generator_arguments(int n, double fraction) {
+    if (n <= 0 || !(fraction > 0.0 && fraction <= 1.0)) {
+        fprintf(stderr, "Error: the dimension must be positive and the fraction in (0, 1]\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Function to generate a random n x n matrix in CSR format (upper triangle only if upper != 0)
+// The same seed gives the same matrix as write_random_matrix.
+int random_csr(int n, double fraction, uint64_t seed, int upper, CsrMatrix* A) {
+    memset(A, 0, sizeof(CsrMatrix));
+    if (check_generator_arguments(n, fraction) != 0) {
+        return 1;
+    }
+    A->n_rows = n;
+    A->n_cols = n;
+    A->fill = fraction;
+    A->scalefactor = 1.0 / fraction;
+    A->row_ptr = calloc((size_t)n + 1, sizeof(size_t));
+    if (A->row_ptr == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+        return 1;
+    }
+    // Rows are generated twice, once to count and once to fill, which is cheaper than growing arrays
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < n; i++) {
+        A->row_ptr[i + 1] = random_row(seed, i, n, fraction, upper, NULL, NULL);
+    }
+    for (int i = 0; i < n; i++) {
+        A->row_ptr[i + 1] += A->row_ptr[i];
+    }
+    A->nnz = A->row_ptr[n];
+    A->col_idx = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(int));
+    A->val = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(double));
+    if (A->col_idx == NULL || A->val == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+        free_csr(A);
+        return 1;
+    }
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < n; i++) {
+        random_row(seed, i, n, fraction, upper, A->col_idx + A->row_ptr[i], A->val + A->row_ptr[i]);
+    }
+    return 0;
+}
+
+// Function to write a random n x n matrix in the text format of the data files
+// The header is the one of the Fortran generator, with scalefactor = 1 / random_fraction as in the
+// bundled files. Rows are generated and written one at a time, so the memory use does not grow
+// with the size of the matrix.
+int write_random_matrix(const char* file_name, int n, double fraction, uint64_t seed, int upper) {
+    if (check_generator_arguments(n, fraction) != 0) {
+        return 1;
+    }
+    FILE* file = fopen(file_name, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening file '%s' for writing\n", file_name);
+        return 1;
+    }
+    int* cols = malloc((size_t)n * sizeof(int));
+    double* vals = malloc((size_t)n * sizeof(double));
+    if (cols == NULL || vals == NULL) {
+        fprintf(stderr, "Memory allocation failed for the generator.\n");
+        free(cols);
+        free(vals);
+        fclose(file);
+        return 1;
+    }
+    fprintf(file, "  random matrices with different degrees of filling \n");
+    fprintf(file, "  please give a random fraction, between zero and 1\n");
+    fprintf(file, "  random_fraction, scalefactor = %22.17f %26.15f     \n", fraction, 1.0 / fraction);
+    fprintf(file, "  please give the matrix dimension \n");
+    fprintf(file, "  matrix will have dimension %12d  x %12d\n", n, n);
+    for (int i = 0; i < n; i++) {
+        size_t count = random_row(seed, i, n, fraction, upper, cols, vals);
+        for (size_t k = 0; k < count; k++) {
+            fprintf(file, "%12d%12d  %.17g\n", i + 1, cols[k] + 1, vals[k]);
+        }
+    }
+    free(cols);
+    free(vals);
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Error writing file '%s'\n", file_name);
+        return 1;
+    }
+    return 0;
+}
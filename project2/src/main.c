@@ -0,0 +1,535 @@
+// main.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "sparse.h"
+
+// Wall-clock time in seconds
+static double wall_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+static void print_usage(void) {
+    printf("Usage: sparse_matrix spmv [matrix_file] [repetitions] [format]\n");
+    printf("       sparse_matrix spgemm [matrix_file_A] [matrix_file_B] [repetitions] [format]\n");
+    printf("       sparse_matrix convert [text_matrix_file] [binary_matrix_file]\n");
+    printf("       sparse_matrix verify [text_matrix_file] [binary_matrix_file]\n");
+    printf("       sparse_matrix generate [dimension] [random_fraction] [seed] [matrix_file] [upper|full]\n");
+    printf("       sparse_matrix solve [matrix_file] [shift] [tolerance]\n");
+    printf("Formats: auto (default), csr, sell, bcsr, dense\n");
+}
+
+// Reads a text matrix file into CSR format
+static int read_text_matrix(const char* file_name, CsrMatrix* A) {
+    CooMatrix coo;
+    if (read_coo(file_name, &coo) != 0) {
+        return 1;
+    }
+    int rc = coo_to_csr(&coo, A);
+    free_coo(&coo);
+    return rc;
+}
+
+// Reads a text or binary matrix file into CSR format, prints its size and fill
+static int load_matrix(const char* file_name, CsrMatrix* A) {
+    int rc = is_csr_binary(file_name) ? map_csr_binary(file_name, A) : read_text_matrix(file_name, A);
+    if (rc != 0) {
+        return 1;
+    }
+    printf("Matrix %s: %d x %d, %zu nonzeros, fill %.4f (header %.4f)\n", file_name, A->n_rows, A->n_cols,
+           A->nnz, (double)A->nnz / ((double)A->n_rows * A->n_cols), A->fill);
+    return 0;
+}
+
+// Largest accepted difference of a product to its reference, relative to the largest reference entry
+#define CHECK_TOLERANCE 1e-12
+
+// Largest absolute difference between two vectors
+static double max_difference(const double* a, const double* b, size_t n) {
+    double diff = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        if (fabs(a[i] - b[i]) > diff) diff = fabs(a[i] - b[i]);
+    }
+    return diff;
+}
+
+// spmv: compares the CSR and CSC products with the dense product and times the CSR product
+// Returns 1 if a product differs from the reference by more than CHECK_TOLERANCE.
+static int run_spmv(int argc, char* argv[]) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+    int repetitions = argc > 3 ? atoi(argv[3]) : 1000;
+    if (repetitions < 1) repetitions = 1;
+    MatrixFormat requested = FORMAT_AUTO;
+    if (argc > 4 && parse_format(argv[4], &requested) != 0) {
+        return 1;
+    }
+
+    CsrMatrix A;
+    if (load_matrix(argv[2], &A) != 0) {
+        return 1;
+    }
+    CscMatrix A_csc;
+    if (csr_to_csc(&A, &A_csc) != 0) {
+        free_csr(&A);
+        return 1;
+    }
+    // Matrices too large to store densely are checked against the CSR product instead
+    int use_dense = (double)A.n_rows * A.n_cols <= FORMAT_DENSE_MAX_ENTRIES;
+    const char* reference = use_dense ? "dense" : "CSR";
+    double* dense = use_dense ? csr_to_dense(&A) : NULL;
+    double* x = malloc((size_t)A.n_cols * sizeof(double));
+    double* y = malloc((size_t)A.n_rows * sizeof(double));
+    double* y_ref = malloc((size_t)A.n_rows * sizeof(double));
+    if ((use_dense && dense == NULL) || x == NULL || y == NULL || y_ref == NULL) {
+        fprintf(stderr, "Memory allocation failed for vectors.\n");
+        return 1;
+    }
+    for (int j = 0; j < A.n_cols; j++) {
+        x[j] = 1.0 + (double)j / A.n_cols;
+    }
+
+    double diff = 0.0;
+    if (use_dense) {
+        dense_matvec(A.n_rows, A.n_cols, dense, x, y_ref);
+        csr_spmv(&A, x, y);
+        diff = max_difference(y, y_ref, A.n_rows);
+        printf("CSR SpMV max difference to dense: %.3e\n", diff);
+    }
+    else {
+        csr_spmv(&A, x, y_ref);
+    }
+    if (csc_spmv(&A_csc, x, y) != 0) {
+        return 1;
+    }
+    double diff_csc = max_difference(y, y_ref, A.n_rows);
+    printf("CSC SpMV max difference to %s: %.3e\n", reference, diff_csc);
+    if (diff_csc > diff) diff = diff_csc;
+    FormattedMatrix M;
+    if (format_matrix(&A, requested, &M) != 0) {
+        return 1;
+    }
+    printf("SpMV format: %s (%s)\n", format_name(M.choice.format), M.choice.reason);
+    formatted_spmv(&M, x, y);
+    double diff_format = max_difference(y, y_ref, A.n_rows);
+    printf("%s SpMV max difference to %s: %.3e\n", format_name(M.choice.format), reference, diff_format);
+    if (diff_format > diff) diff = diff_format;
+    double max_value = 0.0;
+    for (int i = 0; i < A.n_rows; i++) {
+        if (fabs(y_ref[i]) > max_value) max_value = fabs(y_ref[i]);
+    }
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    double start = wall_time();
+    for (int r = 0; r < repetitions; r++) {
+        csr_spmv(&A, x, y);
+    }
+    double elapsed = (wall_time() - start) / repetitions;
+    printf("CSR SpMV (%d threads): %.3e s per product, %.3f GFLOP/s\n", nthreads, elapsed, 2.0 * A.nnz / elapsed * 1e-9);
+
+    start = wall_time();
+    for (int r = 0; r < repetitions; r++) {
+        formatted_spmv(&M, x, y);
+    }
+    elapsed = (wall_time() - start) / repetitions;
+    printf("%s SpMV (%d threads): %.3e s per product, %.3f GFLOP/s\n", format_name(M.choice.format), nthreads, elapsed,
+           2.0 * A.nnz / elapsed * 1e-9);
+
+    if (use_dense) {
+        start = wall_time();
+        for (int r = 0; r < repetitions; r++) {
+            dense_matvec(A.n_rows, A.n_cols, dense, x, y);
+        }
+        elapsed = (wall_time() - start) / repetitions;
+        printf("Dense matvec (%d threads): %.3e s per product\n", nthreads, elapsed);
+    }
+
+    free(dense);
+    free(x);
+    free(y);
+    free(y_ref);
+    free_formatted(&M);
+    free_csc(&A_csc);
+    free_csr(&A);
+    return diff <= CHECK_TOLERANCE * (max_value > 1.0 ? max_value : 1.0) ? 0 : 1;
+}
+
+// Largest difference between the entries of two CSR matrices of the same shape, using a dense row as workspace
+static double csr_max_difference(const CsrMatrix* A, const CsrMatrix* B, double* work) {
+    double diff = 0.0;
+    for (int j = 0; j < A->n_cols; j++) {
+        work[j] = 0.0;
+    }
+    for (int i = 0; i < A->n_rows; i++) {
+        for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            work[A->col_idx[k]] += A->val[k];
+        }
+        for (size_t k = B->row_ptr[i]; k < B->row_ptr[i + 1]; k++) {
+            work[B->col_idx[k]] -= B->val[k];
+        }
+        for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            if (fabs(work[A->col_idx[k]]) > diff) diff = fabs(work[A->col_idx[k]]);
+            work[A->col_idx[k]] = 0.0;
+        }
+        for (size_t k = B->row_ptr[i]; k < B->row_ptr[i + 1]; k++) {
+            if (fabs(work[B->col_idx[k]]) > diff) diff = fabs(work[B->col_idx[k]]);
+            work[B->col_idx[k]] = 0.0;
+        }
+    }
+    return diff;
+}
+
+// spgemm: compares the sparse product C = A B with the dense product and times both
+// Products too large to store densely are checked against the CSR product instead and the dense product is skipped.
+// Returns 1 if a product differs from the reference by more than CHECK_TOLERANCE.
+static int run_spgemm(int argc, char* argv[]) {
+    if (argc < 4) {
+        print_usage();
+        return 1;
+    }
+    int repetitions = argc > 4 ? atoi(argv[4]) : 100;
+    if (repetitions < 1) repetitions = 1;
+    MatrixFormat requested = FORMAT_AUTO;
+    if (argc > 5 && parse_format(argv[5], &requested) != 0) {
+        return 1;
+    }
+
+    int rc = 1;
+    CsrMatrix A = {0}, B = {0}, C = {0}, C_auto = {0};
+    double* A_dense = NULL;
+    double* B_dense = NULL;
+    double* C_dense = NULL;
+    double* C_sparse = NULL;
+    double* work = NULL;
+    if (load_matrix(argv[2], &A) != 0 || load_matrix(argv[3], &B) != 0) {
+        goto cleanup;
+    }
+    size_t n_mult;
+    if (csr_spgemm(&A, &B, &C, &n_mult) != 0) {
+        goto cleanup;
+    }
+    FormatChoice choice;
+    if (auto_spgemm(&A, &B, requested, &C_auto, &choice) != 0) {
+        goto cleanup;
+    }
+    printf("SpGEMM format: %s (%s)\n", format_name(choice.format), choice.reason);
+
+    double n3 = (double)A.n_rows * A.n_cols * B.n_cols;
+    printf("Product: %d x %d, %zu nonzeros, fill %.4f\n", C.n_rows, C.n_cols, C.nnz, C.fill);
+    printf("Multiplications: %zu (%.4e of N^3)\n", n_mult, n_mult / n3);
+
+    int use_dense = (double)A.n_rows * A.n_cols <= FORMAT_DENSE_MAX_ENTRIES &&
+                    (double)B.n_rows * B.n_cols <= FORMAT_DENSE_MAX_ENTRIES &&
+                    (double)C.n_rows * C.n_cols <= FORMAT_DENSE_MAX_ENTRIES;
+    double max_value = 0.0;
+    double diff = 0.0;
+    if (use_dense) {
+        // Reference dense product
+        A_dense = csr_to_dense(&A);
+        B_dense = csr_to_dense(&B);
+        C_dense = malloc((size_t)A.n_rows * B.n_cols * sizeof(double));
+        if (A_dense == NULL || B_dense == NULL || C_dense == NULL) {
+            fprintf(stderr, "Memory allocation failed for dense matrices.\n");
+            goto cleanup;
+        }
+        dense_matmul(A.n_rows, A.n_cols, B.n_cols, A_dense, B_dense, C_dense);
+        for (size_t k = 0; k < (size_t)A.n_rows * B.n_cols; k++) {
+            if (fabs(C_dense[k]) > max_value) max_value = fabs(C_dense[k]);
+        }
+        C_sparse = csr_to_dense(&C);
+        if (C_sparse == NULL) {
+            fprintf(stderr, "Memory allocation failed for dense matrices.\n");
+            goto cleanup;
+        }
+        diff = max_difference(C_sparse, C_dense, (size_t)A.n_rows * B.n_cols);
+        printf("SpGEMM max difference to dense: %.3e (relative %.3e)\n", diff, max_value > 0.0 ? diff / max_value : diff);
+        free(C_sparse);
+        C_sparse = csr_to_dense(&C_auto);
+        if (C_sparse == NULL) {
+            fprintf(stderr, "Memory allocation failed for dense matrices.\n");
+            goto cleanup;
+        }
+        double diff_auto = max_difference(C_sparse, C_dense, (size_t)A.n_rows * B.n_cols);
+        printf("%s product max difference to dense: %.3e\n", format_name(choice.format), diff_auto);
+        if (diff_auto > diff) diff = diff_auto;
+    }
+    else {
+        // Reference CSR product, compared row by row
+        work = malloc((size_t)(C.n_cols > 0 ? C.n_cols : 1) * sizeof(double));
+        if (work == NULL) {
+            fprintf(stderr, "Memory allocation failed for vectors.\n");
+            goto cleanup;
+        }
+        for (size_t k = 0; k < C.nnz; k++) {
+            if (fabs(C.val[k]) > max_value) max_value = fabs(C.val[k]);
+        }
+        diff = csr_max_difference(&C_auto, &C, work);
+        printf("Product too large for a dense reference, checked against the CSR product\n");
+        printf("%s product max difference to CSR: %.3e\n", format_name(choice.format), diff);
+    }
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    double start = wall_time();
+    for (int r = 0; r < repetitions; r++) {
+        free_csr(&C);
+        if (csr_spgemm(&A, &B, &C, NULL) != 0) {
+            goto cleanup;
+        }
+    }
+    double elapsed = (wall_time() - start) / repetitions;
+    printf("SpGEMM (%d threads): %.3e s per product, %.3f GFLOP/s\n", nthreads, elapsed, 2.0 * n_mult / elapsed * 1e-9);
+
+    if (use_dense) {
+        start = wall_time();
+        for (int r = 0; r < repetitions; r++) {
+            dense_matmul(A.n_rows, A.n_cols, B.n_cols, A_dense, B_dense, C_dense);
+        }
+        elapsed = (wall_time() - start) / repetitions;
+        printf("Dense matmul (%d threads): %.3e s per product\n", nthreads, elapsed);
+    }
+
+    start = wall_time();
+    for (int r = 0; r < repetitions; r++) {
+        free_csr(&C_auto);
+        if (auto_spgemm(&A, &B, requested, &C_auto, &choice) != 0) {
+            goto cleanup;
+        }
+    }
+    elapsed = (wall_time() - start) / repetitions;
+    printf("%s product incl. conversions (%d threads): %.3e s per product\n", format_name(choice.format), nthreads, elapsed);
+
+    rc = diff <= CHECK_TOLERANCE * (max_value > 1.0 ? max_value : 1.0) ? 0 : 1;
+
+cleanup:
+    free(A_dense);
+    free(B_dense);
+    free(C_dense);
+    free(C_sparse);
+    free(work);
+    free_csr(&C_auto);
+    free_csr(&A);
+    free_csr(&B);
+    free_csr(&C);
+    return rc;
+}
+
+// convert: writes a text matrix file as binary CSR file and checks the round trip
+static int run_convert(int argc, char* argv[]) {
+    if (argc < 4) {
+        print_usage();
+        return 1;
+    }
+    CsrMatrix A;
+    double start = wall_time();
+    if (read_text_matrix(argv[2], &A) != 0) {
+        return 1;
+    }
+    double parse_time = wall_time() - start;
+    if (write_csr_binary(argv[3], &A) != 0) {
+        free_csr(&A);
+        return 1;
+    }
+    printf("Converted %s (%d x %d, %zu nonzeros) to %s\n", argv[2], A.n_rows, A.n_cols, A.nnz, argv[3]);
+    printf("Text parse time: %.3e s\n", parse_time);
+
+    start = wall_time();
+    CsrMatrix B;
+    if (map_csr_binary(argv[3], &B) != 0) {
+        free_csr(&A);
+        return 1;
+    }
+    printf("Binary map time: %.3e s\n", wall_time() - start);
+    int equal = csr_equal(&A, &B);
+    printf("Round trip: %s\n", equal ? "identical" : "MISMATCH");
+    free_csr(&A);
+    free_csr(&B);
+    return equal ? 0 : 1;
+}
+
+// verify: checks that a binary CSR file holds the same matrix as a text matrix file
+static int run_verify(int argc, char* argv[]) {
+    if (argc < 4) {
+        print_usage();
+        return 1;
+    }
+    CsrMatrix A, B;
+    if (read_text_matrix(argv[2], &A) != 0) {
+        return 1;
+    }
+    if (map_csr_binary(argv[3], &B) != 0) {
+        free_csr(&A);
+        return 1;
+    }
+    int equal = csr_equal(&A, &B) && A.fill == B.fill && A.scalefactor == B.scalefactor;
+    printf("%s and %s are %s\n", argv[2], argv[3], equal ? "identical" : "DIFFERENT");
+    free_csr(&A);
+    free_csr(&B);
+    return equal ? 0 : 1;
+}
+
+// generate: writes a random matrix in the text format of the data files
+static int run_generate(int argc, char* argv[]) {
+    if (argc < 6) {
+        print_usage();
+        return 1;
+    }
+    int n = atoi(argv[2]);
+    double fraction = atof(argv[3]);
+    uint64_t seed = strtoull(argv[4], NULL, 10);
+    int upper = 1;
+    if (argc > 6) {
+        if (strcmp(argv[6], "full") == 0) upper = 0;
+        else if (strcmp(argv[6], "upper") != 0) {
+            print_usage();
+            return 1;
+        }
+    }
+    double start = wall_time();
+    if (write_random_matrix(argv[5], n, fraction, seed, upper) != 0) {
+        return 1;
+    }
+    printf("Wrote %d x %d matrix with random_fraction %g (%s, seed %llu) to %s in %.2f s\n", n, n, fraction,
+           upper ? "upper triangle" : "all entries", (unsigned long long)seed, argv[5], wall_time() - start);
+    return 0;
+}
+
+// Prints one solver result line
+static void print_result(const char* solver, const char* precond, const SolverResult* result, double error, double elapsed) {
+    printf("%-6s %-7s %5d iterations, %-13s residual %.3e, error %.3e, %.3e s\n", solver, precond, result->iterations,
+           result->converged ? "converged," : "NOT converged,", result->residual, error, elapsed);
+}
+
+// solve: symmetrises a matrix stored as upper triangle, finds its lowest eigenvalue with Lanczos
+// and solves (S + shift I) x = b with CG and GMRES and every preconditioner. b is chosen so that
+// the solution is x = 1. Without a given shift, the shift makes the lowest eigenvalue 1 so CG
+// applies (the symmetrised random matrices are indefinite).
+// Returns 1 if Lanczos or one of the solves does not converge or a preconditioner cannot be built.
+static int run_solve(int argc, char* argv[]) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+    double tolerance = argc > 4 ? atof(argv[4]) : SOLVER_TOLERANCE;
+
+    int failed = 1;
+    CsrMatrix U = {0}, S = {0}, A = {0};
+    KrylovWorkspace ws = {0};
+    double* x = NULL;
+    double* b = NULL;
+    if (load_matrix(argv[2], &U) != 0) {
+        goto cleanup;
+    }
+    int rc = csr_symmetrize(&U, &S);
+    free_csr(&U);
+    if (rc != 0) {
+        goto cleanup;
+    }
+    int n = S.n_rows;
+    printf("Symmetrised matrix: %d x %d, %zu nonzeros\n", n, n, S.nnz);
+
+    // Lanczos uses the whole basis, GMRES restarts every GMRES_RESTART steps
+    int basis = LANCZOS_MAX_STEPS > GMRES_RESTART ? LANCZOS_MAX_STEPS : GMRES_RESTART;
+    if (basis > n) basis = n > GMRES_RESTART ? n : GMRES_RESTART;
+    x = malloc((size_t)n * sizeof(double));
+    b = malloc((size_t)n * sizeof(double));
+    if (krylov_workspace_init(&ws, n, basis) != 0 || x == NULL || b == NULL) {
+        fprintf(stderr, "Memory allocation failed for vectors.\n");
+        goto cleanup;
+    }
+
+    SolverResult result;
+    double start = wall_time();
+    lanczos_lowest(&S, tolerance, &ws, x, &result);
+    double elapsed = wall_time() - start;
+    printf("Lanczos lowest eigenvalue %.12f: %d steps, %s residual %.3e, %.3e s\n", result.eigenvalue,
+           result.iterations, result.converged ? "converged," : "NOT converged,", result.residual, elapsed);
+    failed = !result.converged;
+
+    double shift = argc > 3 ? atof(argv[3]) : (result.eigenvalue < 1.0 ? 1.0 - result.eigenvalue : 0.0);
+    if (csr_add_diagonal(&S, shift, &A) != 0) {
+        failed = 1;
+        goto cleanup;
+    }
+    printf("Solving (S + %.6f I) x = b with x = 1, tolerance %.1e\n", shift, tolerance);
+    for (int i = 0; i < n; i++) {
+        x[i] = 1.0;
+    }
+    csr_spmv(&A, x, b);
+
+    for (int solver = 0; solver < 2; solver++) {
+        for (int type = PRECOND_NONE; type <= PRECOND_ILU0; type++) {
+            Preconditioner M;
+            start = wall_time();
+            if (precond_init(&A, (PreconditionerType)type, &M) != 0) {
+                failed = 1;
+                continue;
+            }
+            if (solver == 0) rc = cg_solve(&A, &M, b, x, tolerance, SOLVER_MAX_ITERATIONS, &ws, &result);
+            else rc = gmres_solve(&A, &M, b, x, tolerance, SOLVER_MAX_ITERATIONS, GMRES_RESTART, &ws, &result);
+            elapsed = wall_time() - start;
+            free_precond(&M);
+            if (rc != 0 || !result.converged) {
+                failed = 1;
+            }
+            if (rc != 0) {
+                continue;
+            }
+            double error = 0.0;
+            for (int i = 0; i < n; i++) {
+                if (fabs(x[i] - 1.0) > error) error = fabs(x[i] - 1.0);
+            }
+            print_result(solver == 0 ? "CG" : "GMRES", precond_name((PreconditionerType)type), &result, error, elapsed);
+        }
+    }
+
+cleanup:
+    free(x);
+    free(b);
+    free_krylov_workspace(&ws);
+    free_csr(&A);
+    free_csr(&S);
+    return failed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    if (strcmp(argv[1], "spmv") == 0) {
+        return run_spmv(argc, argv);
+    }
+    if (strcmp(argv[1], "spgemm") == 0) {
+        return run_spgemm(argc, argv);
+    }
+    if (strcmp(argv[1], "convert") == 0) {
+        return run_convert(argc, argv);
+    }
+    if (strcmp(argv[1], "verify") == 0) {
+        return run_verify(argc, argv);
+    }
+    if (strcmp(argv[1], "generate") == 0) {
+        return run_generate(argc, argv);
+    }
+    if (strcmp(argv[1], "solve") == 0) {
+        return run_solve(argc, argv);
+    }
+    print_usage();
+    return 1;
+}
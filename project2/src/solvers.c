@@ -0,0 +1,557 @@
+// solvers.c
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sparse.h"
+
+static const char* precond_names[] = {"none", "jacobi", "ilu0"};
+
+const char* precond_name(PreconditionerType type) {
+    return precond_names[type];
+}
+
+// Function to translate a preconditioner name ("none", "jacobi" or "ilu0")
+int parse_precond(const char* name, PreconditionerType* type) {
+    for (int t = PRECOND_NONE; t <= PRECOND_ILU0; t++) {
+        if (strcmp(name, precond_names[t]) == 0) {
+            *type = (PreconditionerType)t;
+            return 0;
+        }
+    }
+    fprintf(stderr, "Error: unknown preconditioner '%s' (none, jacobi or ilu0)\n", name);
+    return 1;
+}
+
+// Position of the diagonal entry of row i, or (size_t)-1 if it is not stored
+static size_t diagonal_position(const CsrMatrix* A, int i) {
+    for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+        if (A->col_idx[k] == i) return k;
+        if (A->col_idx[k] > i) break;
+    }
+    return (size_t)-1;
+}
+
+// Function to set up the preconditioner M of a square matrix A with a nonzero diagonal
+// Jacobi stores 1 / a_ii. ILU(0) factorises A = L U keeping only the entries in the pattern of
+// A (L unit lower triangular, both stored in lu) with the row-by-row IKJ elimination.
+int precond_init(const CsrMatrix* A, PreconditionerType type, Preconditioner* M) {
+    memset(M, 0, sizeof(Preconditioner));
+    M->type = type;
+    M->n = A->n_rows;
+    if (type == PRECOND_NONE) {
+        return 0;
+    }
+    M->inv_diag = malloc((size_t)A->n_rows * sizeof(double));
+    M->diag_pos = malloc((size_t)A->n_rows * sizeof(size_t));
+    if (M->inv_diag == NULL || M->diag_pos == NULL) {
+        fprintf(stderr, "Memory allocation failed for the preconditioner.\n");
+        free_precond(M);
+        return 1;
+    }
+    for (int i = 0; i < A->n_rows; i++) {
+        M->diag_pos[i] = diagonal_position(A, i);
+        if (M->diag_pos[i] == (size_t)-1 || A->val[M->diag_pos[i]] == 0.0) {
+            fprintf(stderr, "Error: zero diagonal entry in row %d, %s needs a nonzero diagonal\n", i + 1, precond_name(type));
+            free_precond(M);
+            return 1;
+        }
+        M->inv_diag[i] = 1.0 / A->val[M->diag_pos[i]];
+    }
+    if (type == PRECOND_JACOBI) {
+        return 0;
+    }
+
+    // ILU(0): work on a copy of A. position[j] is the position of column j in the current row
+    // (-1 if the row has no entry there), so updates outside the pattern are dropped.
+    M->lu = *A;
+    M->lu.mapping = NULL;
+    M->lu.row_ptr = malloc(((size_t)A->n_rows + 1) * sizeof(size_t));
+    M->lu.col_idx = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(int));
+    M->lu.val = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(double));
+    long long* position = malloc((size_t)A->n_cols * sizeof(long long));
+    if (M->lu.row_ptr == NULL || M->lu.col_idx == NULL || M->lu.val == NULL || position == NULL) {
+        fprintf(stderr, "Memory allocation failed for the preconditioner.\n");
+        free(position);
+        free_precond(M);
+        return 1;
+    }
+    memcpy(M->lu.row_ptr, A->row_ptr, ((size_t)A->n_rows + 1) * sizeof(size_t));
+    memcpy(M->lu.col_idx, A->col_idx, A->nnz * sizeof(int));
+    memcpy(M->lu.val, A->val, A->nnz * sizeof(double));
+    const size_t* row_ptr = M->lu.row_ptr;
+    const int* col = M->lu.col_idx;
+    double* lu = M->lu.val;
+    for (int j = 0; j < A->n_cols; j++) {
+        position[j] = -1;
+    }
+    for (int i = 0; i < A->n_rows; i++) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            position[col[k]] = (long long)k;
+        }
+        for (size_t k = row_ptr[i]; k < M->diag_pos[i]; k++) {
+            int j = col[k];
+            double l_ij = lu[k] * M->inv_diag[j];
+            lu[k] = l_ij;
+            for (size_t kk = M->diag_pos[j] + 1; kk < row_ptr[j + 1]; kk++) {
+                if (position[col[kk]] >= 0) {
+                    lu[position[col[kk]]] -= l_ij * lu[kk];
+                }
+            }
+        }
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            position[col[k]] = -1;
+        }
+        if (lu[M->diag_pos[i]] == 0.0) {
+            fprintf(stderr, "Error: zero pivot in row %d of the ILU(0) factorisation\n", i + 1);
+            free(position);
+            free_precond(M);
+            return 1;
+        }
+        M->inv_diag[i] = 1.0 / lu[M->diag_pos[i]];
+    }
+    free(position);
+    return 0;
+}
+
+// Function to calculate z = M^-1 r (r and z must not overlap)
+void precond_apply(const Preconditioner* M, const double* r, double* z) {
+    if (M->type == PRECOND_NONE) {
+        memcpy(z, r, (size_t)M->n * sizeof(double));
+        return;
+    }
+    if (M->type == PRECOND_JACOBI) {
+        for (int i = 0; i < M->n; i++) {
+            z[i] = M->inv_diag[i] * r[i];
+        }
+        return;
+    }
+    // ILU(0): forward substitution with the unit L, backward substitution with U
+    const CsrMatrix* LU = &M->lu;
+    for (int i = 0; i < M->n; i++) {
+        double sum = r[i];
+        for (size_t k = LU->row_ptr[i]; k < M->diag_pos[i]; k++) {
+            sum -= LU->val[k] * z[LU->col_idx[k]];
+        }
+        z[i] = sum;
+    }
+    for (int i = M->n - 1; i >= 0; i--) {
+        double sum = z[i];
+        for (size_t k = M->diag_pos[i] + 1; k < LU->row_ptr[i + 1]; k++) {
+            sum -= LU->val[k] * z[LU->col_idx[k]];
+        }
+        z[i] = sum * M->inv_diag[i];
+    }
+}
+
+void free_precond(Preconditioner* M) {
+    free(M->inv_diag);
+    free(M->diag_pos);
+    free(M->lu.row_ptr);
+    free(M->lu.col_idx);
+    free(M->lu.val);
+    memset(M, 0, sizeof(Preconditioner));
+}
+
+// Function to allocate all vectors the solvers need for a matrix of size n, with room for a
+// Krylov basis of `basis` vectors (the GMRES restart length or the number of Lanczos steps).
+// The solvers themselves allocate nothing.
+int krylov_workspace_init(KrylovWorkspace* ws, int n, int basis) {
+    memset(ws, 0, sizeof(KrylovWorkspace));
+    ws->n = n;
+    ws->basis = basis;
+    ws->r = malloc((size_t)n * sizeof(double));
+    ws->z = malloc((size_t)n * sizeof(double));
+    ws->p = malloc((size_t)n * sizeof(double));
+    ws->q = malloc((size_t)n * sizeof(double));
+    ws->V = malloc((size_t)(basis + 1) * n * sizeof(double));
+    ws->H = malloc((size_t)(basis + 1) * basis * sizeof(double));
+    ws->cs = malloc((size_t)basis * sizeof(double));
+    ws->sn = malloc((size_t)basis * sizeof(double));
+    ws->g = malloc((size_t)(basis + 1) * sizeof(double));
+    ws->alpha = malloc((size_t)(basis + 1) * sizeof(double));
+    ws->beta = malloc((size_t)(basis + 1) * sizeof(double));
+    ws->s = malloc((size_t)(basis + 1) * sizeof(double));
+    ws->tri = malloc((size_t)5 * (basis + 1) * sizeof(double));
+    if (ws->r == NULL || ws->z == NULL || ws->p == NULL || ws->q == NULL || ws->V == NULL || ws->H == NULL ||
+        ws->cs == NULL || ws->sn == NULL || ws->g == NULL || ws->alpha == NULL || ws->beta == NULL ||
+        ws->s == NULL || ws->tri == NULL) {
+        fprintf(stderr, "Memory allocation failed for the solver work vectors.\n");
+        free_krylov_workspace(ws);
+        return 1;
+    }
+    return 0;
+}
+
+void free_krylov_workspace(KrylovWorkspace* ws) {
+    free(ws->r);
+    free(ws->z);
+    free(ws->p);
+    free(ws->q);
+    free(ws->V);
+    free(ws->H);
+    free(ws->cs);
+    free(ws->sn);
+    free(ws->g);
+    free(ws->alpha);
+    free(ws->beta);
+    free(ws->s);
+    free(ws->tri);
+    memset(ws, 0, sizeof(KrylovWorkspace));
+}
+
+static double dot(int n, const double* x, const double* y) {
+    double sum = 0.0;
+    #pragma omp parallel for reduction(+:sum)
+    for (int i = 0; i < n; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+// ||b - A x|| / ||b|| with `work` as scratch vector
+static double relative_residual(const CsrMatrix* A, const double* b, const double* x, double* work) {
+    csr_spmv(A, x, work);
+    double rr = 0.0;
+    double bb = 0.0;
+    for (int i = 0; i < A->n_rows; i++) {
+        rr += (b[i] - work[i]) * (b[i] - work[i]);
+        bb += b[i] * b[i];
+    }
+    return bb > 0.0 ? sqrt(rr / bb) : sqrt(rr);
+}
+
+// Function to solve A x = b for a symmetric positive definite A with preconditioned conjugate
+// gradients, starting from x = 0, until ||r|| / ||b|| < tol or max_iter iterations
+// The product q = A p returns p . q in the same pass, and x, r, z = M^-1 r and the dot products
+// r . r and r . z are updated in one loop (for ILU(0) z needs the triangular solves in between).
+int cg_solve(const CsrMatrix* A, const Preconditioner* M, const double* b, double* x, double tol, int max_iter,
+             KrylovWorkspace* ws, SolverResult* result) {
+    assert(A->n_rows == A->n_cols); // csr_spmv_fused needs a square matrix
+    int n = A->n_rows;
+    double *r = ws->r, *z = ws->z, *p = ws->p, *q = ws->q;
+    const double* inv_diag = M->type == PRECOND_JACOBI ? M->inv_diag : NULL;
+    int separate_apply = M->type == PRECOND_ILU0;
+    memset(result, 0, sizeof(SolverResult));
+    memset(x, 0, (size_t)n * sizeof(double));
+    memcpy(r, b, (size_t)n * sizeof(double));
+    precond_apply(M, r, z);
+    memcpy(p, z, (size_t)n * sizeof(double));
+    double rz = dot(n, r, z);
+    double b_norm = sqrt(dot(n, b, b));
+    if (b_norm == 0.0) {
+        result->converged = 1;
+        return 0;
+    }
+
+    for (int iteration = 1; iteration <= max_iter; iteration++) {
+        double pq = csr_spmv_fused(A, p, 0.0, NULL, q);
+        if (!(pq > 0.0)) {
+            fprintf(stderr, "Error: CG breakdown (p . A p = %g), the matrix is not positive definite\n", pq);
+            result->iterations = iteration;
+            return 1;
+        }
+        double alpha = rz / pq;
+        double rr = 0.0;
+        double rz_new = 0.0;
+        #pragma omp parallel for reduction(+:rr, rz_new)
+        for (int i = 0; i < n; i++) {
+            x[i] += alpha * p[i];
+            double ri = r[i] - alpha * q[i];
+            r[i] = ri;
+            double zi = inv_diag != NULL ? inv_diag[i] * ri : ri;
+            if (!separate_apply) z[i] = zi;
+            rr += ri * ri;
+            rz_new += ri * zi;
+        }
+        result->iterations = iteration;
+        if (sqrt(rr) / b_norm < tol) {
+            result->converged = 1;
+            break;
+        }
+        if (separate_apply) {
+            precond_apply(M, r, z);
+            rz_new = dot(n, r, z);
+        }
+        double beta = rz_new / rz;
+        rz = rz_new;
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++) {
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+    result->residual = relative_residual(A, b, x, q);
+    return 0;
+}
+
+// w -= sum_i h_i V_i over the basis vectors i = 0 .. count-1 with modified Gram-Schmidt, storing
+// h_i = w . V_i in h. Each pass subtracts V_i and accumulates w . V_(i+1) on the updated w, so
+// every dot product shares its pass over w with the previous axpy.
+static void orthogonalize(int n, int count, const double* V, double* w, double* h) {
+    if (count == 0) return;
+    double next = dot(n, w, V);
+    for (int i = 0; i < count; i++) {
+        const double* v = V + (size_t)i * n;
+        const double* v_next = i + 1 < count ? V + (size_t)(i + 1) * n : NULL;
+        double coeff = next;
+        h[i] = coeff;
+        next = 0.0;
+        #pragma omp parallel for reduction(+:next)
+        for (int k = 0; k < n; k++) {
+            double wk = w[k] - coeff * v[k];
+            w[k] = wk;
+            if (v_next != NULL) next += wk * v_next[k];
+        }
+    }
+}
+
+// Function to solve A x = b with right-preconditioned restarted GMRES(restart), starting from x = 0,
+// until ||b - A x|| / ||b|| < tol or max_iter iterations in total. restart is limited to the basis
+// size of the workspace.
+// The Arnoldi basis is orthogonalised with fused modified Gram-Schmidt and the Hessenberg matrix
+// reduced with Givens rotations, so the residual norm is known at every step.
+int gmres_solve(const CsrMatrix* A, const Preconditioner* M, const double* b, double* x, double tol, int max_iter,
+                int restart, KrylovWorkspace* ws, SolverResult* result) {
+    int n = A->n_rows;
+    int m = restart < ws->basis ? restart : ws->basis;
+    double *V = ws->V, *H = ws->H, *cs = ws->cs, *sn = ws->sn, *g = ws->g, *y = ws->s;
+    memset(result, 0, sizeof(SolverResult));
+    memset(x, 0, (size_t)n * sizeof(double));
+    double b_norm = sqrt(dot(n, b, b));
+    if (b_norm == 0.0) {
+        result->converged = 1;
+        return 0;
+    }
+
+    int iteration = 0;
+    while (iteration < max_iter && !result->converged) {
+        // r = b - A x as first basis vector
+        csr_spmv(A, x, ws->r);
+        for (int i = 0; i < n; i++) {
+            V[i] = b[i] - ws->r[i];
+        }
+        double beta = sqrt(dot(n, V, V));
+        if (beta / b_norm < tol) {
+            result->converged = 1;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            V[i] /= beta;
+        }
+        memset(g, 0, (size_t)(m + 1) * sizeof(double));
+        g[0] = beta;
+
+        int k = 0;
+        while (k < m && iteration < max_iter) {
+            double* h = H + (size_t)k * (m + 1);
+            double* w = V + (size_t)(k + 1) * n;
+            precond_apply(M, V + (size_t)k * n, ws->z);
+            csr_spmv(A, ws->z, w);
+            orthogonalize(n, k + 1, V, w, h);
+            h[k + 1] = sqrt(dot(n, w, w));
+            if (h[k + 1] != 0.0) {
+                double inv = 1.0 / h[k + 1];
+                for (int i = 0; i < n; i++) {
+                    w[i] *= inv;
+                }
+            }
+            // Apply the previous rotations to the new column, then eliminate h[k + 1]
+            for (int i = 0; i < k; i++) {
+                double t = cs[i] * h[i] + sn[i] * h[i + 1];
+                h[i + 1] = -sn[i] * h[i] + cs[i] * h[i + 1];
+                h[i] = t;
+            }
+            double norm = hypot(h[k], h[k + 1]);
+            cs[k] = norm > 0.0 ? h[k] / norm : 1.0;
+            sn[k] = norm > 0.0 ? h[k + 1] / norm : 0.0;
+            h[k] = norm;
+            h[k + 1] = 0.0;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+            k++;
+            iteration++;
+            if (fabs(g[k]) / b_norm < tol || norm == 0.0) {
+                break;
+            }
+        }
+
+        // Solve the k x k upper triangular system H y = g and update x += M^-1 V y
+        for (int i = k - 1; i >= 0; i--) {
+            double sum = g[i];
+            for (int j = i + 1; j < k; j++) {
+                sum -= H[(size_t)j * (m + 1) + i] * y[j];
+            }
+            y[i] = H[(size_t)i * (m + 1) + i] != 0.0 ? sum / H[(size_t)i * (m + 1) + i] : 0.0;
+        }
+        memset(ws->q, 0, (size_t)n * sizeof(double));
+        for (int j = 0; j < k; j++) {
+            const double* v = V + (size_t)j * n;
+            for (int i = 0; i < n; i++) {
+                ws->q[i] += y[j] * v[i];
+            }
+        }
+        precond_apply(M, ws->q, ws->p);
+        for (int i = 0; i < n; i++) {
+            x[i] += ws->p[i];
+        }
+        if (fabs(g[k]) / b_norm < tol) {
+            result->converged = 1;
+        }
+    }
+    result->iterations = iteration;
+    result->residual = relative_residual(A, b, x, ws->q);
+    if (result->residual >= tol) {
+        result->converged = 0; // the recursive residual can drift from the true one
+    }
+    return 0;
+}
+
+// Number of eigenvalues of the k x k symmetric tridiagonal matrix (alpha, beta) below x,
+// from the signs of the pivots of T - x I (Sturm sequence)
+static int sturm_count(int k, const double* alpha, const double* beta, double x) {
+    int count = 0;
+    double d = 1.0;
+    for (int i = 0; i < k; i++) {
+        double off = i > 0 ? beta[i] * beta[i] / d : 0.0;
+        d = alpha[i] - x - off;
+        if (d == 0.0) d = -1e-300;
+        if (d < 0.0) count++;
+    }
+    return count;
+}
+
+// Lowest eigenvalue of the tridiagonal matrix with diagonal alpha[0..k-1] and off-diagonal
+// beta[1..k-1], by bisection, and its normalised eigenvector s by inverse iteration (Gaussian
+// elimination with partial pivoting as in LAPACK's dgtsv). work needs 5 k entries.
+static double tridiagonal_lowest(int k, const double* alpha, const double* beta, double* s, double* work) {
+    double lo = alpha[0];
+    double hi = alpha[0];
+    for (int i = 0; i < k; i++) {
+        double radius = (i > 0 ? fabs(beta[i]) : 0.0) + (i + 1 < k ? fabs(beta[i + 1]) : 0.0);
+        if (alpha[i] - radius < lo) lo = alpha[i] - radius;
+        if (alpha[i] + radius > hi) hi = alpha[i] + radius;
+    }
+    double scale = fabs(lo) > fabs(hi) ? fabs(lo) : fabs(hi);
+    while (hi - lo > 4e-16 * (scale > 0.0 ? scale : 1.0)) {
+        double mid = 0.5 * (lo + hi);
+        if (mid <= lo || mid >= hi) break;
+        if (sturm_count(k, alpha, beta, mid) >= 1) hi = mid;
+        else lo = mid;
+    }
+    double theta = 0.5 * (lo + hi);
+
+    double *dl = work, *d = work + k, *du = work + 2 * k, *du2 = work + 3 * k;
+    for (int i = 0; i < k; i++) {
+        s[i] = 1.0;
+    }
+    for (int sweep = 0; sweep < 3; sweep++) {
+        for (int i = 0; i < k; i++) {
+            d[i] = alpha[i] - theta;
+            if (i + 1 < k) {
+                dl[i] = beta[i + 1];
+                du[i] = beta[i + 1];
+            }
+            du2[i] = 0.0;
+        }
+        for (int i = 0; i + 1 < k; i++) {
+            if (fabs(d[i]) >= fabs(dl[i])) {
+                if (d[i] == 0.0) d[i] = 1e-300;
+                double fact = dl[i] / d[i];
+                d[i + 1] -= fact * du[i];
+                s[i + 1] -= fact * s[i];
+            }
+            else {
+                double fact = d[i] / dl[i];
+                d[i] = dl[i];
+                double temp = d[i + 1];
+                d[i + 1] = du[i] - fact * temp;
+                if (i + 2 < k) {
+                    du2[i] = du[i + 1];
+                    du[i + 1] = -fact * du2[i];
+                }
+                du[i] = temp;
+                temp = s[i];
+                s[i] = s[i + 1];
+                s[i + 1] = temp - fact * s[i + 1];
+            }
+        }
+        if (d[k - 1] == 0.0) d[k - 1] = 1e-300;
+        s[k - 1] /= d[k - 1];
+        if (k > 1) s[k - 2] = (s[k - 2] - du[k - 2] * s[k - 1]) / d[k - 2];
+        for (int i = k - 3; i >= 0; i--) {
+            s[i] = (s[i] - du[i] * s[i + 1] - du2[i] * s[i + 2]) / d[i];
+        }
+        double norm = 0.0;
+        for (int i = 0; i < k; i++) {
+            norm += s[i] * s[i];
+        }
+        norm = sqrt(norm);
+        for (int i = 0; i < k; i++) {
+            s[i] /= norm;
+        }
+    }
+    return theta;
+}
+
+// Function to find the lowest eigenvalue of a symmetric matrix A with the Lanczos method
+// Every step w = A v_k - beta_k v_(k-1) and alpha_k = v_k . w come from one fused product, then w
+// is fully reorthogonalised against the stored basis (which keeps spurious copies of converged
+// eigenvalues out). The step stops when the residual estimate beta_(k+1) |s_k| of the lowest Ritz
+// pair is below tol (relative to the eigenvalue), after at most the workspace basis size steps.
+// The eigenvector is returned in v (length n), the true residual ||A v - lambda v|| in result.
+int lanczos_lowest(const CsrMatrix* A, double tol, KrylovWorkspace* ws, double* v, SolverResult* result) {
+    assert(A->n_rows == A->n_cols); // csr_spmv_fused needs a square matrix
+    int n = A->n_rows;
+    int max_steps = ws->basis < n ? ws->basis : n;
+    double *V = ws->V, *alpha = ws->alpha, *beta = ws->beta, *s = ws->s;
+    memset(result, 0, sizeof(SolverResult));
+
+    // Deterministic start vector with components along every eigenvector in general
+    for (int i = 0; i < n; i++) {
+        V[i] = 1.0 + (double)i / n;
+    }
+    double norm = sqrt(dot(n, V, V));
+    for (int i = 0; i < n; i++) {
+        V[i] /= norm;
+    }
+    beta[0] = 0.0;
+    double theta = 0.0;
+    int steps = 0;
+    for (int k = 0; k < max_steps; k++) {
+        double* vk = V + (size_t)k * n;
+        double* w = V + (size_t)(k + 1) * n;
+        alpha[k] = csr_spmv_fused(A, vk, beta[k], k > 0 ? vk - n : NULL, w);
+        orthogonalize(n, k + 1, V, w, ws->H); // the projections written to ws->H are not needed
+        beta[k + 1] = sqrt(dot(n, w, w));
+        steps = k + 1;
+        theta = tridiagonal_lowest(steps, alpha, beta, s, ws->tri);
+        double estimate = beta[k + 1] * fabs(s[k]);
+        if (estimate < tol * (fabs(theta) > 1.0 ? fabs(theta) : 1.0) || beta[k + 1] == 0.0) {
+            result->converged = 1;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            w[i] /= beta[k + 1];
+        }
+    }
+
+    // Ritz vector v = V s and its true residual
+    memset(v, 0, (size_t)n * sizeof(double));
+    for (int j = 0; j < steps; j++) {
+        const double* vj = V + (size_t)j * n;
+        for (int i = 0; i < n; i++) {
+            v[i] += s[j] * vj[i];
+        }
+    }
+    csr_spmv(A, v, ws->r);
+    double rr = 0.0;
+    for (int i = 0; i < n; i++) {
+        rr += (ws->r[i] - theta * v[i]) * (ws->r[i] - theta * v[i]);
+    }
+    result->iterations = steps;
+    result->eigenvalue = theta;
+    result->residual = sqrt(rr);
+    return 0;
+}
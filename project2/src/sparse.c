@@ -0,0 +1,296 @@
+// sparse.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "sparse.h"
+
+typedef struct {
+    int col;
+    double val;
+} RowEntry;
+
+static int compare_entries(const void* a, const void* b) {
+    int x = ((const RowEntry*)a)->col;
+    int y = ((const RowEntry*)b)->col;
+    return (x > y) - (x < y);
+}
+
+// Sorts the entries of one row by column: insertion sort for short rows, qsort for long ones
+static int sort_row(int* col, double* val, size_t n) {
+    if (n > 32) {
+        RowEntry* entries = malloc(n * sizeof(RowEntry));
+        if (entries == NULL) {
+            return 1;
+        }
+        for (size_t k = 0; k < n; k++) {
+            entries[k].col = col[k];
+            entries[k].val = val[k];
+        }
+        qsort(entries, n, sizeof(RowEntry), compare_entries);
+        for (size_t k = 0; k < n; k++) {
+            col[k] = entries[k].col;
+            val[k] = entries[k].val;
+        }
+        free(entries);
+        return 0;
+    }
+    for (size_t k = 1; k < n; k++) {
+        int c = col[k];
+        double v = val[k];
+        size_t m = k;
+        while (m > 0 && col[m - 1] > c) {
+            col[m] = col[m - 1];
+            val[m] = val[m - 1];
+            m--;
+        }
+        col[m] = c;
+        val[m] = v;
+    }
+    return 0;
+}
+
+// Function to convert a matrix from coordinate to CSR format
+// Entries are bucketed by row with a counting sort, sorted by column within each row,
+// and duplicated (row, col) entries are summed.
+int coo_to_csr(const CooMatrix* A, CsrMatrix* B) {
+    memset(B, 0, sizeof(CsrMatrix));
+    B->n_rows = A->n_rows;
+    B->n_cols = A->n_cols;
+    B->fill = A->fill;
+    B->scalefactor = A->scalefactor;
+    B->row_ptr = calloc((size_t)A->n_rows + 1, sizeof(size_t));
+    B->col_idx = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(int));
+    B->val = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(double));
+    if (B->row_ptr == NULL || B->col_idx == NULL || B->val == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+        free_csr(B);
+        return 1;
+    }
+
+    for (size_t k = 0; k < A->nnz; k++) {
+        B->row_ptr[A->row[k] + 1]++;
+    }
+    for (int i = 0; i < A->n_rows; i++) {
+        B->row_ptr[i + 1] += B->row_ptr[i];
+    }
+    size_t* next = malloc(((size_t)A->n_rows + 1) * sizeof(size_t));
+    if (next == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+        free_csr(B);
+        return 1;
+    }
+    memcpy(next, B->row_ptr, ((size_t)A->n_rows + 1) * sizeof(size_t));
+    for (size_t k = 0; k < A->nnz; k++) {
+        size_t pos = next[A->row[k]]++;
+        B->col_idx[pos] = A->col[k];
+        B->val[pos] = A->val[k];
+    }
+    free(next);
+
+    // Sort every row and merge duplicates, compacting the arrays in place
+    size_t out = 0;
+    size_t start = 0;
+    for (int i = 0; i < A->n_rows; i++) {
+        size_t end = B->row_ptr[i + 1];
+        if (sort_row(B->col_idx + start, B->val + start, end - start) != 0) {
+            fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+            free_csr(B);
+            return 1;
+        }
+        B->row_ptr[i] = out;
+        for (size_t k = start; k < end; k++) {
+            if (out > B->row_ptr[i] && B->col_idx[out - 1] == B->col_idx[k]) {
+                B->val[out - 1] += B->val[k];
+            }
+            else {
+                B->col_idx[out] = B->col_idx[k];
+                B->val[out] = B->val[k];
+                out++;
+            }
+        }
+        start = end;
+    }
+    B->row_ptr[A->n_rows] = out;
+    B->nnz = out;
+    return 0;
+}
+
+// Function to convert a matrix from CSR to CSC format (a transpose of the index structure)
+int csr_to_csc(const CsrMatrix* A, CscMatrix* B) {
+    memset(B, 0, sizeof(CscMatrix));
+    B->n_rows = A->n_rows;
+    B->n_cols = A->n_cols;
+    B->nnz = A->nnz;
+    B->col_ptr = calloc((size_t)A->n_cols + 1, sizeof(size_t));
+    B->row_idx = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(int));
+    B->val = malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(double));
+    if (B->col_ptr == NULL || B->row_idx == NULL || B->val == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSC matrix.\n");
+        free_csc(B);
+        return 1;
+    }
+
+    for (size_t k = 0; k < A->nnz; k++) {
+        B->col_ptr[A->col_idx[k] + 1]++;
+    }
+    for (int j = 0; j < A->n_cols; j++) {
+        B->col_ptr[j + 1] += B->col_ptr[j];
+    }
+    // Rows are visited in increasing order, so every column comes out sorted by row
+    size_t* next = malloc(((size_t)A->n_cols + 1) * sizeof(size_t));
+    if (next == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSC matrix.\n");
+        free_csc(B);
+        return 1;
+    }
+    memcpy(next, B->col_ptr, ((size_t)A->n_cols + 1) * sizeof(size_t));
+    for (int i = 0; i < A->n_rows; i++) {
+        for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            size_t pos = next[A->col_idx[k]]++;
+            B->row_idx[pos] = i;
+            B->val[pos] = A->val[k];
+        }
+    }
+    free(next);
+    return 0;
+}
+
+// Function to expand a CSR matrix to a dense row-major n_rows x n_cols array (NULL on failure)
+double* csr_to_dense(const CsrMatrix* A) {
+    double* D = calloc((size_t)A->n_rows * A->n_cols, sizeof(double));
+    if (D == NULL) {
+        fprintf(stderr, "Memory allocation failed for dense matrix.\n");
+        return NULL;
+    }
+    for (int i = 0; i < A->n_rows; i++) {
+        for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            D[(size_t)i * A->n_cols + A->col_idx[k]] = A->val[k];
+        }
+    }
+    return D;
+}
+
+// Function to build the full symmetric matrix from a matrix storing one triangle, as the data files
+// do: every off-diagonal entry (i, j) is mirrored to (j, i), the diagonal is kept once. Entries
+// stored in both triangles would be summed, so the input must hold only one of them.
+int csr_symmetrize(const CsrMatrix* A, CsrMatrix* B) {
+    memset(B, 0, sizeof(CsrMatrix));
+    if (A->n_rows != A->n_cols) {
+        fprintf(stderr, "Error: cannot symmetrize a %d x %d matrix\n", A->n_rows, A->n_cols);
+        return 1;
+    }
+    CooMatrix coo;
+    memset(&coo, 0, sizeof(CooMatrix));
+    coo.n_rows = A->n_rows;
+    coo.n_cols = A->n_cols;
+    coo.fill = A->fill;
+    coo.scalefactor = A->scalefactor;
+    size_t capacity = 2 * A->nnz;
+    coo.row = malloc((capacity > 0 ? capacity : 1) * sizeof(int));
+    coo.col = malloc((capacity > 0 ? capacity : 1) * sizeof(int));
+    coo.val = malloc((capacity > 0 ? capacity : 1) * sizeof(double));
+    if (coo.row == NULL || coo.col == NULL || coo.val == NULL) {
+        fprintf(stderr, "Memory allocation failed for the symmetric matrix.\n");
+        free_coo(&coo);
+        return 1;
+    }
+    for (int i = 0; i < A->n_rows; i++) {
+        for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            int j = A->col_idx[k];
+            coo.row[coo.nnz] = i;
+            coo.col[coo.nnz] = j;
+            coo.val[coo.nnz++] = A->val[k];
+            if (j != i) {
+                coo.row[coo.nnz] = j;
+                coo.col[coo.nnz] = i;
+                coo.val[coo.nnz++] = A->val[k];
+            }
+        }
+    }
+    int rc = coo_to_csr(&coo, B);
+    free_coo(&coo);
+    return rc;
+}
+
+// Function to calculate B = A + shift I for a square matrix. Missing diagonal entries are inserted
+// (also for shift 0), so B has the full diagonal that ILU(0) and Jacobi need.
+int csr_add_diagonal(const CsrMatrix* A, double shift, CsrMatrix* B) {
+    memset(B, 0, sizeof(CsrMatrix));
+    if (A->n_rows != A->n_cols) {
+        fprintf(stderr, "Error: cannot shift the diagonal of a %d x %d matrix\n", A->n_rows, A->n_cols);
+        return 1;
+    }
+    B->n_rows = A->n_rows;
+    B->n_cols = A->n_cols;
+    B->fill = A->fill;
+    B->scalefactor = A->scalefactor;
+    B->row_ptr = calloc((size_t)A->n_rows + 1, sizeof(size_t));
+    B->col_idx = malloc((A->nnz + (size_t)A->n_rows) * sizeof(int));
+    B->val = malloc((A->nnz + (size_t)A->n_rows) * sizeof(double));
+    if (B->row_ptr == NULL || B->col_idx == NULL || B->val == NULL) {
+        fprintf(stderr, "Memory allocation failed for CSR matrix.\n");
+        free_csr(B);
+        return 1;
+    }
+    size_t out = 0;
+    for (int i = 0; i < A->n_rows; i++) {
+        int diagonal_done = 0;
+        for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            int j = A->col_idx[k];
+            if (!diagonal_done && j >= i) {
+                B->col_idx[out] = i;
+                B->val[out++] = shift + (j == i ? A->val[k] : 0.0);
+                diagonal_done = 1;
+                if (j == i) continue;
+            }
+            B->col_idx[out] = j;
+            B->val[out++] = A->val[k];
+        }
+        if (!diagonal_done) {
+            B->col_idx[out] = i;
+            B->val[out++] = shift;
+        }
+        B->row_ptr[i + 1] = out;
+    }
+    B->nnz = out;
+    return 0;
+}
+
+void free_coo(CooMatrix* A) {
+    free(A->row);
+    free(A->col);
+    free(A->val);
+    A->row = NULL;
+    A->col = NULL;
+    A->val = NULL;
+    A->nnz = 0;
+}
+
+void free_csr(CsrMatrix* A) {
+    if (A->mapping != NULL) {
+        munmap(A->mapping, A->mapping_size);
+        A->mapping = NULL;
+        A->mapping_size = 0;
+    }
+    else {
+        free(A->row_ptr);
+        free(A->col_idx);
+        free(A->val);
+    }
+    A->row_ptr = NULL;
+    A->col_idx = NULL;
+    A->val = NULL;
+    A->nnz = 0;
+}
+
+void free_csc(CscMatrix* A) {
+    free(A->col_ptr);
+    free(A->row_idx);
+    free(A->val);
+    A->col_ptr = NULL;
+    A->row_idx = NULL;
+    A->val = NULL;
+    A->nnz = 0;
+}
@@ -0,0 +1,192 @@
+// sparse.h
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest number of columns for which the SpGEMM uses a dense accumulator per thread instead of a hash table
+#ifndef SPGEMM_DENSE_COLUMNS
+#define SPGEMM_DENSE_COLUMNS (1 << 18)
+#endif
+
+// Storage format selection (see format.c): slice height and sorting window of SELL-C-sigma,
+// block size of block-CSR, and the thresholds of the automatic choice
+#define SELL_CHUNK 8
+#define SELL_SIGMA 256
+#define BCSR_BLOCK 4
+#define FORMAT_DENSE_FILL 0.45        // fill from which dense storage beats CSR for SpMV
+#define FORMAT_DENSE_MAX_ENTRIES (1 << 24) // largest matrix (entries) stored densely
+#define FORMAT_SELL_MAX_PADDING 1.25  // largest ratio of stored to nonzero entries for SELL-C-sigma
+#define FORMAT_SELL_MIN_ROW 4.0       // smallest mean row length for SELL-C-sigma
+#define FORMAT_BCSR_MIN_BLOCK_FILL 0.5 // smallest mean fill of the nonzero blocks for block-CSR
+#define FORMAT_SPGEMM_DENSE_RATIO 0.1 // multiplications / (n m p) from which the dense product is used
+
+// Sparse matrix in coordinate format, as read from the data files (0-based indices)
+typedef struct {
+    int n_rows, n_cols;
+    size_t nnz;
+    int* row;
+    int* col;
+    double* val;
+    double fill;         // random_fraction given in the file header
+    double scalefactor;  // scalefactor given in the file header
+} CooMatrix;
+
+// Compressed sparse row format: the entries of row i are row_ptr[i] .. row_ptr[i+1]-1, sorted by column
+typedef struct {
+    int n_rows, n_cols;
+    size_t nnz;
+    size_t* row_ptr;
+    int* col_idx;
+    double* val;
+    double fill;
+    double scalefactor;
+    void* mapping;        // start of the memory-mapped binary file the arrays point into, NULL if allocated
+    size_t mapping_size;
+} CsrMatrix;
+
+// Compressed sparse column format: the entries of column j are col_ptr[j] .. col_ptr[j+1]-1, sorted by row
+typedef struct {
+    int n_rows, n_cols;
+    size_t nnz;
+    size_t* col_ptr;
+    int* row_idx;
+    double* val;
+} CscMatrix;
+
+// Reading and conversions (return 0 on success, 1 on error)
+int read_coo(const char* file_name, CooMatrix* A);
+int coo_to_csr(const CooMatrix* A, CsrMatrix* B);
+int csr_to_csc(const CsrMatrix* A, CscMatrix* B);
+double* csr_to_dense(const CsrMatrix* A);
+int csr_symmetrize(const CsrMatrix* A, CsrMatrix* B);
+int csr_add_diagonal(const CsrMatrix* A, double shift, CsrMatrix* B);
+void free_coo(CooMatrix* A);
+void free_csr(CsrMatrix* A);
+void free_csc(CscMatrix* A);
+
+// SELL-C-sigma: rows are sorted by length within windows of SELL_SIGMA rows and packed in slices
+// of SELL_CHUNK rows padded to the longest row of the slice. Within a slice the entries are stored
+// column-major: entry k of slice row r is at slice_ptr[s] + k * SELL_CHUNK + r.
+typedef struct {
+    int n_rows, n_cols, n_slices;
+    size_t nnz;              // stored entries including padding
+    size_t* slice_ptr;
+    int* slice_width;
+    int* row;                // original row of every slice row (-1 for padding rows)
+    int* col_idx;
+    double* val;
+} SellMatrix;
+
+// Block-CSR with dense BCSR_BLOCK x BCSR_BLOCK blocks stored row-major, in CSR order of the blocks
+typedef struct {
+    int n_rows, n_cols, n_block_rows;
+    size_t n_blocks;
+    size_t* block_ptr;
+    int* block_col;
+    double* val;
+} BcsrMatrix;
+
+typedef enum { FORMAT_AUTO, FORMAT_CSR, FORMAT_SELL, FORMAT_BCSR, FORMAT_DENSE } MatrixFormat;
+
+// Chosen format of an operation and the reason for the choice
+typedef struct {
+    MatrixFormat format;
+    char reason[256];
+} FormatChoice;
+
+// A CSR matrix together with its copy in the format chosen for SpMV
+typedef struct {
+    FormatChoice choice;
+    const CsrMatrix* csr;
+    SellMatrix sell;
+    BcsrMatrix bcsr;
+    double* dense;
+} FormattedMatrix;
+
+// Storage formats and automatic selection (return 0 on success, 1 on error)
+const char* format_name(MatrixFormat format);
+int parse_format(const char* name, MatrixFormat* format);
+int csr_to_sell(const CsrMatrix* A, SellMatrix* B);
+int csr_to_bcsr(const CsrMatrix* A, BcsrMatrix* B);
+int dense_to_csr(int n_rows, int n_cols, const double* D, CsrMatrix* A);
+void sell_spmv(const SellMatrix* A, const double* x, double* y);
+void bcsr_spmv(const BcsrMatrix* A, const double* x, double* y);
+void free_sell(SellMatrix* A);
+void free_bcsr(BcsrMatrix* A);
+int format_matrix(const CsrMatrix* A, MatrixFormat requested, FormattedMatrix* M);
+void formatted_spmv(const FormattedMatrix* M, const double* x, double* y);
+void free_formatted(FormattedMatrix* M);
+int auto_spgemm(const CsrMatrix* A, const CsrMatrix* B, MatrixFormat requested, CsrMatrix* C, FormatChoice* choice);
+
+// Random matrices in the format of the data files (return 0 on success, 1 on error)
+int random_csr(int n, double fraction, uint64_t seed, int upper, CsrMatrix* A);
+int write_random_matrix(const char* file_name, int n, double fraction, uint64_t seed, int upper);
+
+// Preconditioned Krylov solvers and Lanczos eigensolver (see solvers.c), for square matrices only
+#define SOLVER_TOLERANCE 1e-10
+#define SOLVER_MAX_ITERATIONS 2000
+#define GMRES_RESTART 50
+#define LANCZOS_MAX_STEPS 300
+
+typedef enum { PRECOND_NONE, PRECOND_JACOBI, PRECOND_ILU0 } PreconditionerType;
+
+typedef struct {
+    PreconditionerType type;
+    int n;
+    double* inv_diag;    // Jacobi: 1 / a_ii, ILU(0): 1 / u_ii
+    size_t* diag_pos;    // position of the diagonal entry of every row
+    CsrMatrix lu;        // ILU(0): unit L below and U on and above the diagonal, in the pattern of A
+} Preconditioner;
+
+// Work vectors of the solvers, allocated once so the iterations do not allocate
+typedef struct {
+    int n, basis;
+    double *r, *z, *p, *q;       // n each
+    double* V;                   // basis + 1 vectors of length n (GMRES/Lanczos basis)
+    double* H;                   // (basis + 1) x basis Hessenberg matrix, column-major
+    double *cs, *sn, *g;         // GMRES Givens rotations and rotated residual
+    double *alpha, *beta, *s;    // Lanczos tridiagonal matrix and its eigenvector (GMRES: y)
+    double* tri;                 // 5 (basis + 1) for the tridiagonal eigenvector
+} KrylovWorkspace;
+
+typedef struct {
+    int iterations;
+    int converged;
+    double residual;    // ||b - A x|| / ||b|| for the linear solvers, ||A v - lambda v|| for Lanczos
+    double eigenvalue;
+} SolverResult;
+
+const char* precond_name(PreconditionerType type);
+int parse_precond(const char* name, PreconditionerType* type);
+int precond_init(const CsrMatrix* A, PreconditionerType type, Preconditioner* M);
+void precond_apply(const Preconditioner* M, const double* r, double* z);
+void free_precond(Preconditioner* M);
+int krylov_workspace_init(KrylovWorkspace* ws, int n, int basis);
+void free_krylov_workspace(KrylovWorkspace* ws);
+int cg_solve(const CsrMatrix* A, const Preconditioner* M, const double* b, double* x, double tol, int max_iter,
+             KrylovWorkspace* ws, SolverResult* result);
+int gmres_solve(const CsrMatrix* A, const Preconditioner* M, const double* b, double* x, double tol, int max_iter,
+                int restart, KrylovWorkspace* ws, SolverResult* result);
+int lanczos_lowest(const CsrMatrix* A, double tol, KrylovWorkspace* ws, double* v, SolverResult* result);
+
+// Binary CSR files that are memory-mapped without parsing (write and map return 0 on success, 1 on error)
+int is_csr_binary(const char* file_name);
+int write_csr_binary(const char* file_name, const CsrMatrix* A);
+int map_csr_binary(const char* file_name, CsrMatrix* A);
+int csr_equal(const CsrMatrix* A, const CsrMatrix* B);
+
+// Sparse matrix-vector products y = A x
+size_t csr_partition_row(const CsrMatrix* A, int part, int nparts);
+void csr_spmv(const CsrMatrix* A, const double* x, double* y);
+// csr_spmv_fused returns x . y, which uses x[i] for row i, so A must be square
+double csr_spmv_fused(const CsrMatrix* A, const double* x, double beta, const double* z, double* y);
+int csc_spmv(const CscMatrix* A, const double* x, double* y);
+void dense_matvec(int n_rows, int n_cols, const double* A, const double* x, double* y);
+
+// Sparse matrix-matrix products C = A B
+int csr_spgemm(const CsrMatrix* A, const CsrMatrix* B, CsrMatrix* C, size_t* n_mult);
+void dense_matmul(int n, int m, int p, const double* A, const double* B, double* C);
+
+#endif // SPARSE_H
@@ -0,0 +1,214 @@
+// sparse_bin.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sparse.h"
+
+// Layout of a binary CSR file, all numbers in the byte order of the machine that wrote it:
+//   header (CSR_BINARY_HEADER bytes): magic "SPCSR001", byte-order mark, the dimensions, nnz,
+//   fill, scalefactor and the offsets of the three sections
+//   row_ptr: n_rows + 1 uint64, col_idx: nnz int32, val: nnz double
+// Every section starts at a multiple of CSR_BINARY_ALIGN so the mapped arrays can be used in place.
+#define CSR_BINARY_MAGIC "SPCSR001"
+#define CSR_BINARY_BYTE_ORDER 0x01020304u
+#define CSR_BINARY_HEADER 128
+#define CSR_BINARY_ALIGN 64
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t reserved;
+    uint64_t n_rows, n_cols, nnz;
+    double fill, scalefactor;
+    uint64_t row_ptr_offset, col_idx_offset, val_offset;
+    uint64_t file_size;
+} CsrBinaryHeader;
+
+_Static_assert(sizeof(CsrBinaryHeader) <= CSR_BINARY_HEADER, "binary CSR header too large");
+_Static_assert(sizeof(size_t) == sizeof(uint64_t), "binary CSR files need a 64-bit size_t");
+
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + CSR_BINARY_ALIGN - 1) / CSR_BINARY_ALIGN * CSR_BINARY_ALIGN;
+}
+
+// Section offsets and file size of an n_rows x ? matrix with nnz entries
+static void csr_binary_layout(CsrBinaryHeader* header, uint64_t n_rows, uint64_t nnz) {
+    header->row_ptr_offset = CSR_BINARY_HEADER;
+    header->col_idx_offset = align_offset(header->row_ptr_offset + (n_rows + 1) * sizeof(uint64_t));
+    header->val_offset = align_offset(header->col_idx_offset + nnz * sizeof(int32_t));
+    header->file_size = header->val_offset + nnz * sizeof(double);
+}
+
+// Returns 1 if the file starts with the magic of a binary CSR file
+int is_csr_binary(const char* file_name) {
+    FILE* file = fopen(file_name, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    char magic[8];
+    int found = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, CSR_BINARY_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return found;
+}
+
+// Writes `size` bytes followed by zero padding up to the offset `next`
+static int write_section(FILE* file, const void* data, size_t size, uint64_t* position, uint64_t next) {
+    static const char zeros[CSR_BINARY_ALIGN > CSR_BINARY_HEADER ? CSR_BINARY_ALIGN : CSR_BINARY_HEADER];
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        return 1;
+    }
+    *position += size;
+    if (next > *position && fwrite(zeros, 1, next - *position, file) != next - *position) {
+        return 1;
+    }
+    *position = next > *position ? next : *position;
+    return 0;
+}
+
+// Function to write A to a binary CSR file
+int write_csr_binary(const char* file_name, const CsrMatrix* A) {
+    CsrBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CSR_BINARY_MAGIC, sizeof(header.magic));
+    header.byte_order = CSR_BINARY_BYTE_ORDER;
+    header.n_rows = (uint64_t)A->n_rows;
+    header.n_cols = (uint64_t)A->n_cols;
+    header.nnz = A->nnz;
+    header.fill = A->fill;
+    header.scalefactor = A->scalefactor;
+    csr_binary_layout(&header, header.n_rows, header.nnz);
+
+    FILE* file = fopen(file_name, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening file '%s' for writing\n", file_name);
+        return 1;
+    }
+    uint64_t position = 0;
+    int error = write_section(file, &header, sizeof(header), &position, header.row_ptr_offset)
+             || write_section(file, A->row_ptr, ((size_t)A->n_rows + 1) * sizeof(size_t), &position, header.col_idx_offset)
+             || write_section(file, A->col_idx, A->nnz * sizeof(int), &position, header.val_offset)
+             || write_section(file, A->val, A->nnz * sizeof(double), &position, header.file_size);
+    if (fclose(file) != 0) error = 1;
+    if (error) {
+        fprintf(stderr, "Error writing file '%s'\n", file_name);
+        return 1;
+    }
+    return 0;
+}
+
+// Checks the index arrays of a mapped matrix, returns the problem found or NULL if they are valid
+static const char* csr_index_error(const CsrMatrix* A) {
+    if (A->row_ptr[0] != 0 || A->row_ptr[A->n_rows] != A->nnz) {
+        return "invalid row pointers";
+    }
+    int decreasing = 0;
+    #pragma omp parallel for schedule(static) reduction(||:decreasing)
+    for (int i = 0; i < A->n_rows; i++) {
+        decreasing = decreasing || A->row_ptr[i + 1] < A->row_ptr[i];
+    }
+    if (decreasing) {
+        return "decreasing row pointers";
+    }
+    int out_of_range = 0;
+    #pragma omp parallel for schedule(static) reduction(||:out_of_range)
+    for (size_t k = 0; k < A->nnz; k++) {
+        out_of_range = out_of_range || (unsigned)A->col_idx[k] >= (unsigned)A->n_cols;
+    }
+    if (out_of_range) {
+        return "column index out of range";
+    }
+    return NULL;
+}
+
+// Function to map a binary CSR file into memory
+// The arrays of A point directly into the mapping (private copy-on-write pages, so A may still be
+// modified without changing the file); free_csr unmaps it. The header, the row pointers (from 0 to
+// nnz, never decreasing) and the column indices (in [0, n_cols)) are checked, so a truncated,
+// corrupt or foreign file is rejected instead of being read out of bounds by the kernels. The check
+// reads the index arrays once, the values are only read when they are used.
+int map_csr_binary(const char* file_name, CsrMatrix* A) {
+    memset(A, 0, sizeof(CsrMatrix));
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening file '%s'\n", file_name);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < CSR_BINARY_HEADER) {
+        fprintf(stderr, "Error: '%s' is not a binary CSR file\n", file_name);
+        close(fd);
+        return 1;
+    }
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Error mapping file '%s'\n", file_name);
+        return 1;
+    }
+
+    CsrBinaryHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    // The section sizes are bounded by the file size before the layout is computed, so the products can't wrap around
+    uint64_t file_size = (uint64_t)st.st_size;
+    int sections_fit = header.nnz <= file_size / sizeof(int32_t) && header.n_rows < file_size / sizeof(uint64_t);
+    CsrBinaryHeader expected = header;
+    if (sections_fit) {
+        csr_binary_layout(&expected, header.n_rows, header.nnz);
+    }
+    const char* reason = NULL;
+    if (memcmp(header.magic, CSR_BINARY_MAGIC, sizeof(header.magic)) != 0) {
+        reason = "wrong magic";
+    }
+    else if (header.byte_order != CSR_BINARY_BYTE_ORDER) {
+        reason = "written on a machine with a different byte order";
+    }
+    else if (header.n_rows == 0 || header.n_cols == 0 || header.n_rows > INT32_MAX || header.n_cols > INT32_MAX) {
+        reason = "invalid dimension";
+    }
+    else if (!sections_fit) {
+        reason = "sections larger than the file";
+    }
+    else if (header.row_ptr_offset != expected.row_ptr_offset || header.col_idx_offset != expected.col_idx_offset ||
+             header.val_offset != expected.val_offset || header.file_size != expected.file_size) {
+        reason = "inconsistent section offsets";
+    }
+    else if (file_size < header.file_size) {
+        reason = "file is truncated";
+    }
+    if (reason == NULL) {
+        A->n_rows = (int)header.n_rows;
+        A->n_cols = (int)header.n_cols;
+        A->nnz = header.nnz;
+        A->fill = header.fill;
+        A->scalefactor = header.scalefactor;
+        A->row_ptr = (size_t*)((char*)mapping + header.row_ptr_offset);
+        A->col_idx = (int*)((char*)mapping + header.col_idx_offset);
+        A->val = (double*)((char*)mapping + header.val_offset);
+        reason = csr_index_error(A);
+    }
+    if (reason != NULL) {
+        fprintf(stderr, "Error: '%s' is not a valid binary CSR file (%s)\n", file_name, reason);
+        munmap(mapping, (size_t)st.st_size);
+        memset(A, 0, sizeof(CsrMatrix));
+        return 1;
+    }
+    A->mapping = mapping;
+    A->mapping_size = (size_t)st.st_size;
+    return 0;
+}
+
+// Returns 1 if A and B have the same size and bit-identical entries
+int csr_equal(const CsrMatrix* A, const CsrMatrix* B) {
+    if (A->n_rows != B->n_rows || A->n_cols != B->n_cols || A->nnz != B->nnz) {
+        return 0;
+    }
+    return memcmp(A->row_ptr, B->row_ptr, ((size_t)A->n_rows + 1) * sizeof(size_t)) == 0 &&
+           memcmp(A->col_idx, B->col_idx, A->nnz * sizeof(int)) == 0 &&
+           memcmp(A->val, B->val, A->nnz * sizeof(double)) == 0;
+}
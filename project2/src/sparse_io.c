@@ -0,0 +1,113 @@
+// sparse_io.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sparse.h"
+
+// Grows the coordinate arrays of A to hold at least n entries
+static int coo_reserve(CooMatrix* A, size_t* capacity, size_t n) {
+    if (n <= *capacity) {
+        return 0;
+    }
+    size_t new_capacity = *capacity > 0 ? 2 * *capacity : 1024;
+    while (new_capacity < n) new_capacity *= 2;
+    int* row = realloc(A->row, new_capacity * sizeof(int));
+    if (row != NULL) A->row = row;
+    int* col = realloc(A->col, new_capacity * sizeof(int));
+    if (col != NULL) A->col = col;
+    double* val = realloc(A->val, new_capacity * sizeof(double));
+    if (val != NULL) A->val = val;
+    if (row == NULL || col == NULL || val == NULL) {
+        fprintf(stderr, "Memory allocation failed for %zu matrix elements.\n", n);
+        return 1;
+    }
+    *capacity = new_capacity;
+    return 0;
+}
+
+// Function to read a sparse matrix in the format of the data files
+// Every element is on its own line as "row col value" with 1-based indices. The matrix_25_* files
+// start with a 5-line header written by the Fortran generator, where the line
+// "random_fraction, scalefactor = <fill> <scale>" gives the fill and "matrix will have dimension
+// <n> x <m>" the size. The MATRIX_125_* files have no header, their size is the largest index read
+// and their fill and scalefactor are set to 0.
+int read_coo(const char* file_name, CooMatrix* A) {
+    memset(A, 0, sizeof(CooMatrix));
+    FILE* file = fopen(file_name, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening file '%s'\n", file_name);
+        return 1;
+    }
+
+    char line[1024];
+    size_t capacity = 0;
+    size_t line_number = 0;
+    int have_dimension = 0;
+    int max_row = 0;
+    int max_col = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        int i, j;
+        double value;
+        int n_read = sscanf(line, "%d %d %lf", &i, &j, &value);
+        if (n_read == EOF) {
+            continue; // Blank line
+        }
+
+        // Header lines come before the first element and are recognised by their keywords
+        if (n_read != 3 && A->nnz == 0 && line_number <= 5) {
+            char* p;
+            if ((p = strstr(line, "random_fraction")) != NULL && (p = strchr(p, '=')) != NULL) {
+                if (sscanf(p + 1, "%lf %lf", &A->fill, &A->scalefactor) != 2) {
+                    fprintf(stderr, "Error reading the fill fraction in '%s'\n", file_name);
+                    fclose(file);
+                    return 1;
+                }
+            }
+            // The prompt line before also contains "dimension", only the line with the numbers counts
+            if ((p = strstr(line, "dimension")) != NULL &&
+                sscanf(p + strlen("dimension"), "%d x %d", &A->n_rows, &A->n_cols) == 2) {
+                if (A->n_rows <= 0 || A->n_cols <= 0) {
+                    fprintf(stderr, "Error: invalid matrix dimension in the header of '%s'\n", file_name);
+                    fclose(file);
+                    return 1;
+                }
+                have_dimension = 1;
+            }
+            continue;
+        }
+
+        // Read the element and convert the indices to 0-based
+        if (n_read != 3 || i < 1 || j < 1 || (have_dimension && (i > A->n_rows || j > A->n_cols))) {
+            fprintf(stderr, "Error reading matrix element on line %zu of '%s'\n", line_number, file_name);
+            fclose(file);
+            free_coo(A);
+            return 1;
+        }
+        if (coo_reserve(A, &capacity, A->nnz + 1) != 0) {
+            fclose(file);
+            free_coo(A);
+            return 1;
+        }
+        A->row[A->nnz] = i - 1;
+        A->col[A->nnz] = j - 1;
+        A->val[A->nnz] = value;
+        A->nnz++;
+        if (i > max_row) max_row = i;
+        if (j > max_col) max_col = j;
+    }
+    fclose(file);
+
+    // Without header the matrix is square and as large as the largest index
+    if (!have_dimension) {
+        A->n_rows = max_row > max_col ? max_row : max_col;
+        A->n_cols = A->n_rows;
+    }
+    if (A->n_rows <= 0) {
+        fprintf(stderr, "Error: no matrix elements in '%s'\n", file_name);
+        free_coo(A);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,307 @@
+// spgemm.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sparse.h"
+
+// Accumulator for one row of C = A B, one per thread. With a dense accumulator `marker[j]` holds
+// the last row that touched column j and `values` is indexed by column (n_cols entries). With a
+// hash accumulator both arrays are an open-addressing table of `size` slots keyed by column.
+typedef struct {
+    int dense;
+    size_t size;
+    int* marker;     // dense: row stamp per column, hash: column per slot (-1 = empty)
+    double* values;
+    int* columns;    // columns of the current row in order of insertion
+} RowAccumulator;
+
+static int accumulator_init(RowAccumulator* acc, int n_cols, int dense) {
+    memset(acc, 0, sizeof(RowAccumulator));
+    acc->dense = dense;
+    if (dense) {
+        acc->size = (size_t)n_cols;
+        acc->marker = malloc((size_t)n_cols * sizeof(int));
+        acc->values = calloc((size_t)n_cols, sizeof(double));
+        acc->columns = malloc(((size_t)n_cols + 1) * sizeof(int)); // +1 for the branch-free writes
+        if (acc->marker == NULL || acc->values == NULL || acc->columns == NULL) {
+            return 1;
+        }
+        for (int j = 0; j < n_cols; j++) {
+            acc->marker[j] = -1;
+        }
+    }
+    return 0;
+}
+
+// Makes sure the hash table has at least twice as many slots as the row can have entries, sets *size
+// to the number of slots used for this row and empties them
+static int accumulator_reset_hash(RowAccumulator* acc, size_t max_entries, size_t* size) {
+    *size = 16;
+    while (*size < 2 * max_entries) *size *= 2;
+    if (*size > acc->size) {
+        free(acc->marker);
+        free(acc->values);
+        free(acc->columns);
+        acc->marker = malloc(*size * sizeof(int));
+        acc->values = malloc(*size * sizeof(double));
+        acc->columns = malloc(*size / 2 * sizeof(int));
+        acc->size = *size;
+        if (acc->marker == NULL || acc->values == NULL || acc->columns == NULL) {
+            acc->size = 0;
+            return 1;
+        }
+    }
+    for (size_t s = 0; s < *size; s++) {
+        acc->marker[s] = -1;
+    }
+    return 0;
+}
+
+static void accumulator_free(RowAccumulator* acc) {
+    free(acc->marker);
+    free(acc->values);
+    free(acc->columns);
+}
+
+// Slot of column j in the hash table (inserting it if needed), sets *is_new for new columns
+static size_t hash_slot(RowAccumulator* acc, size_t size, int j, int* is_new) {
+    size_t mask = size - 1;
+    size_t s = ((size_t)j * 2654435761u) & mask;
+    while (acc->marker[s] != -1 && acc->marker[s] != j) {
+        s = (s + 1) & mask;
+    }
+    *is_new = acc->marker[s] == -1;
+    acc->marker[s] = j;
+    return s;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts the columns of one row of C: insertion sort for short rows, qsort for long ones
+static void sort_columns(int* columns, size_t n) {
+    if (n > 64) {
+        qsort(columns, n, sizeof(int), compare_ints);
+        return;
+    }
+    for (size_t k = 1; k < n; k++) {
+        int c = columns[k];
+        size_t m = k;
+        while (m > 0 && columns[m - 1] > c) {
+            columns[m] = columns[m - 1];
+            m--;
+        }
+        columns[m] = c;
+    }
+}
+
+// Multiplications needed for row i of A B (upper bound of the number of entries in row i of C)
+static size_t row_flops(const CsrMatrix* A, const CsrMatrix* B, int i) {
+    size_t flops = 0;
+    for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+        int a_col = A->col_idx[k];
+        flops += B->row_ptr[a_col + 1] - B->row_ptr[a_col];
+    }
+    return flops;
+}
+
+// Collects the columns of row i of A B in acc->columns and returns their number. With values != 0
+// the products are also accumulated in acc->values. `size` is the hash table size of this row.
+// Whether a column is new is close to random, so the dense loop adds it without a branch:
+// the column is always written and the count only advances for new ones. Dense values start
+// at zero and are zeroed again when the row is copied to C.
+static size_t accumulate_row(const CsrMatrix* A, const CsrMatrix* B, int i, RowAccumulator* acc, size_t size, int values) {
+    size_t count = 0;
+    for (size_t ka = A->row_ptr[i]; ka < A->row_ptr[i + 1]; ka++) {
+        int a_col = A->col_idx[ka];
+        double a_val = A->val[ka];
+        size_t kb_end = B->row_ptr[a_col + 1];
+        if (acc->dense) {
+            for (size_t kb = B->row_ptr[a_col]; kb < kb_end; kb++) {
+                int j = B->col_idx[kb];
+                int is_new = acc->marker[j] != i;
+                acc->marker[j] = i;
+                acc->columns[count] = j;
+                count += is_new;
+                if (values) acc->values[j] += a_val * B->val[kb];
+            }
+        }
+        else {
+            for (size_t kb = B->row_ptr[a_col]; kb < kb_end; kb++) {
+                int is_new;
+                size_t slot = hash_slot(acc, size, B->col_idx[kb], &is_new);
+                if (is_new) {
+                    acc->columns[count++] = B->col_idx[kb];
+                    if (values) acc->values[slot] = 0.0;
+                }
+                if (values) acc->values[slot] += a_val * B->val[kb];
+            }
+        }
+    }
+    return count;
+}
+
+// Function to calculate the sparse product C = A B with Gustavson's row-by-row algorithm
+// A symbolic pass counts the entries of every row of C so C is allocated with its exact size,
+// then a numeric pass accumulates every row and writes it sorted by column. Rows are
+// distributed dynamically over the threads, every thread has its own accumulator: a dense one
+// (marker array over the columns) when B has at most SPGEMM_DENSE_COLUMNS columns, otherwise a
+// hash table sized for the row. The number of multiplications is stored in *n_mult if not NULL.
+int csr_spgemm(const CsrMatrix* A, const CsrMatrix* B, CsrMatrix* C, size_t* n_mult) {
+    memset(C, 0, sizeof(CsrMatrix));
+    if (A->n_cols != B->n_rows) {
+        fprintf(stderr, "Error: cannot multiply a %d x %d matrix with a %d x %d matrix\n", A->n_rows, A->n_cols, B->n_rows, B->n_cols);
+        return 1;
+    }
+    C->n_rows = A->n_rows;
+    C->n_cols = B->n_cols;
+    C->row_ptr = calloc((size_t)C->n_rows + 1, sizeof(size_t));
+    if (C->row_ptr == NULL) {
+        fprintf(stderr, "Memory allocation failed for the product matrix.\n");
+        return 1;
+    }
+    int dense = B->n_cols <= SPGEMM_DENSE_COLUMNS;
+    int error = 0;
+    size_t total_flops = 0;
+
+    // Symbolic pass: number of entries of every row of C
+    #pragma omp parallel reduction(||:error) reduction(+:total_flops)
+    {
+        RowAccumulator acc;
+        error = accumulator_init(&acc, B->n_cols, dense);
+        #pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < A->n_rows; i++) {
+            if (error) continue;
+            size_t flops = row_flops(A, B, i);
+            total_flops += flops;
+            size_t size = 0;
+            if (!dense && accumulator_reset_hash(&acc, flops, &size) != 0) {
+                error = 1;
+                continue;
+            }
+            C->row_ptr[i + 1] = accumulate_row(A, B, i, &acc, size, 0);
+        }
+        accumulator_free(&acc);
+    }
+    if (error) {
+        fprintf(stderr, "Memory allocation failed for the SpGEMM accumulators.\n");
+        free_csr(C);
+        return 1;
+    }
+    for (int i = 0; i < C->n_rows; i++) {
+        C->row_ptr[i + 1] += C->row_ptr[i];
+    }
+    C->nnz = C->row_ptr[C->n_rows];
+    C->col_idx = malloc((C->nnz > 0 ? C->nnz : 1) * sizeof(int));
+    C->val = malloc((C->nnz > 0 ? C->nnz : 1) * sizeof(double));
+    if (C->col_idx == NULL || C->val == NULL) {
+        fprintf(stderr, "Memory allocation failed for the product matrix.\n");
+        free_csr(C);
+        return 1;
+    }
+
+    // Numeric pass: accumulate every row and copy it to C sorted by column
+    #pragma omp parallel reduction(||:error)
+    {
+        RowAccumulator acc;
+        error = accumulator_init(&acc, B->n_cols, dense);
+        #pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < A->n_rows; i++) {
+            if (error) continue;
+            size_t size = 0;
+            if (!dense && accumulator_reset_hash(&acc, row_flops(A, B, i), &size) != 0) {
+                error = 1;
+                continue;
+            }
+            size_t count = accumulate_row(A, B, i, &acc, size, 1);
+            // A dense accumulator holding more than 1/8 of the columns is cheaper to scan in
+            // column order (branch-free, like accumulate_row) than to sort
+            if (acc.dense && count * 8 >= (size_t)B->n_cols) {
+                size_t n = 0;
+                for (int j = 0; j < B->n_cols; j++) {
+                    acc.columns[n] = j;
+                    n += acc.marker[j] == i;
+                }
+            }
+            else {
+                sort_columns(acc.columns, count);
+            }
+            size_t out = C->row_ptr[i];
+            for (size_t k = 0; k < count; k++) {
+                int j = acc.columns[k];
+                int is_new;
+                C->col_idx[out + k] = j;
+                if (acc.dense) {
+                    C->val[out + k] = acc.values[j];
+                    acc.values[j] = 0.0;
+                }
+                else {
+                    C->val[out + k] = acc.values[hash_slot(&acc, size, j, &is_new)];
+                }
+            }
+        }
+        accumulator_free(&acc);
+    }
+    if (error) {
+        fprintf(stderr, "Memory allocation failed for the SpGEMM accumulators.\n");
+        free_csr(C);
+        return 1;
+    }
+
+    C->fill = (double)C->nnz / ((double)C->n_rows * C->n_cols);
+    if (n_mult != NULL) {
+        *n_mult = total_flops;
+    }
+    return 0;
+}
+
+// Function to calculate C = A B for dense row-major matrices (A is n x m, B is m x p)
+// A true dense product: every entry of A is used, zeros included, so the time depends only on the
+// sizes. The i-k-j loop order runs over rows of B and C with unit stride, and as in dense_matvec
+// four rows of A and C are processed together so every row of B loaded serves four rows of C.
+// Every entry is still summed in k order, so the result does not depend on the blocking.
+void dense_matmul(int n, int m, int p, const double* A, const double* B, double* C) {
+    #pragma omp parallel for schedule(static)
+    for (int i0 = 0; i0 < n; i0 += 4) {
+        int rows = n - i0 < 4 ? n - i0 : 4;
+        memset(C + (size_t)i0 * p, 0, (size_t)rows * p * sizeof(double));
+        if (rows == 4) {
+            const double* a0 = A + (size_t)i0 * m;
+            const double* a1 = a0 + m;
+            const double* a2 = a1 + m;
+            const double* a3 = a2 + m;
+            double* c0 = C + (size_t)i0 * p;
+            double* c1 = c0 + p;
+            double* c2 = c1 + p;
+            double* c3 = c2 + p;
+            for (int k = 0; k < m; k++) {
+                const double* b = B + (size_t)k * p;
+                double x0 = a0[k], x1 = a1[k], x2 = a2[k], x3 = a3[k];
+                #pragma omp simd
+                for (int j = 0; j < p; j++) {
+                    c0[j] += x0 * b[j];
+                    c1[j] += x1 * b[j];
+                    c2[j] += x2 * b[j];
+                    c3[j] += x3 * b[j];
+                }
+            }
+        }
+        else {
+            for (int i = i0; i < n; i++) {
+                double* c = C + (size_t)i * p;
+                for (int k = 0; k < m; k++) {
+                    double a = A[(size_t)i * m + k];
+                    const double* b = B + (size_t)k * p;
+                    #pragma omp simd
+                    for (int j = 0; j < p; j++) {
+                        c[j] += a * b[j];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,187 @@
+// spmv.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "sparse.h"
+
+// Function to find the first row of part `part` out of `nparts` when the rows are split in
+// contiguous blocks with about the same number of nonzeros (not the same number of rows).
+// Returns the first row i with row_ptr[i] >= part * nnz / nparts; part == nparts gives n_rows.
+size_t csr_partition_row(const CsrMatrix* A, int part, int nparts) {
+    if (part <= 0) {
+        return 0;
+    }
+    if (part >= nparts) {
+        return (size_t)A->n_rows;
+    }
+    size_t target = A->nnz * (size_t)part / (size_t)nparts;
+    size_t lo = 0;
+    size_t hi = (size_t)A->n_rows;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (A->row_ptr[mid] < target) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Function to calculate y = A x for a CSR matrix
+// Every thread takes one nnz-balanced block of rows, so rows of very different lengths don't
+// leave threads idle, and streams through its part of col_idx/val once.
+void csr_spmv(const CsrMatrix* A, const double* x, double* y) {
+    #pragma omp parallel
+    {
+        int nthreads = 1;
+        int thread = 0;
+#ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        thread = omp_get_thread_num();
+#endif
+        size_t first = csr_partition_row(A, thread, nthreads);
+        size_t last = csr_partition_row(A, thread + 1, nthreads);
+        for (size_t i = first; i < last; i++) {
+            double sum = 0.0;
+            for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+                sum += A->val[k] * x[A->col_idx[k]];
+            }
+            y[i] = sum;
+        }
+    }
+}
+
+// Function to calculate y = A x - beta z (z may be NULL if beta is 0) and return x . y
+// The Krylov solvers need the dot product right after every product (p . A p in CG, alpha in
+// Lanczos), so it is accumulated while y is written instead of in a second pass over x and y.
+// x . y pairs row i with x[i], so A has to be square (n_rows == n_cols).
+double csr_spmv_fused(const CsrMatrix* A, const double* x, double beta, const double* z, double* y) {
+    double dot = 0.0;
+    #pragma omp parallel reduction(+:dot)
+    {
+        int nthreads = 1;
+        int thread = 0;
+#ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        thread = omp_get_thread_num();
+#endif
+        size_t first = csr_partition_row(A, thread, nthreads);
+        size_t last = csr_partition_row(A, thread + 1, nthreads);
+        for (size_t i = first; i < last; i++) {
+            double sum = beta != 0.0 ? -beta * z[i] : 0.0;
+            for (size_t k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+                sum += A->val[k] * x[A->col_idx[k]];
+            }
+            y[i] = sum;
+            dot += x[i] * sum;
+        }
+    }
+    return dot;
+}
+
+// Function to calculate y = A x for a CSC matrix
+// Columns scatter into y, so every thread accumulates an nnz-balanced block of columns into a
+// private copy of y. The copies are allocated before the parallel region and summed row-parallel
+// at the end, so threads neither wait on each other nor exit inside the region.
+// Returns 1 if the private copies cannot be allocated.
+int csc_spmv(const CscMatrix* A, const double* x, double* y) {
+    int max_threads = 1;
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    size_t n_rows = (size_t)A->n_rows;
+    double* y_local = NULL;
+    if (max_threads > 1) {
+        y_local = malloc((size_t)max_threads * (n_rows > 0 ? n_rows : 1) * sizeof(double));
+        if (y_local == NULL) {
+            fprintf(stderr, "Memory allocation failed in csc_spmv.\n");
+            return 1;
+        }
+    }
+    #pragma omp parallel num_threads(max_threads)
+    {
+        int nthreads = 1;
+        int thread = 0;
+#ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        thread = omp_get_thread_num();
+#endif
+        // Same balancing as csr_partition_row, on the column pointers
+        size_t bounds[2];
+        for (int b = 0; b < 2; b++) {
+            size_t target = A->nnz * (size_t)(thread + b) / (size_t)nthreads;
+            size_t lo = 0;
+            size_t hi = (size_t)A->n_cols;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (A->col_ptr[mid] < target) lo = mid + 1;
+                else hi = mid;
+            }
+            bounds[b] = thread + b == nthreads ? (size_t)A->n_cols : lo;
+        }
+
+        double* y_thread = nthreads > 1 ? y_local + (size_t)thread * n_rows : y;
+        memset(y_thread, 0, n_rows * sizeof(double));
+        for (size_t j = bounds[0]; j < bounds[1]; j++) {
+            double xj = x[j];
+            for (size_t k = A->col_ptr[j]; k < A->col_ptr[j + 1]; k++) {
+                y_thread[A->row_idx[k]] += A->val[k] * xj;
+            }
+        }
+        if (nthreads > 1) {
+            // All private copies must be complete before the rows are summed
+            #pragma omp barrier
+            #pragma omp for schedule(static)
+            for (size_t i = 0; i < n_rows; i++) {
+                double sum = 0.0;
+                for (int t = 0; t < nthreads; t++) {
+                    sum += y_local[(size_t)t * n_rows + i];
+                }
+                y[i] = sum;
+            }
+        }
+    }
+    free(y_local);
+    return 0;
+}
+
+// Function to calculate y = A x for a dense row-major matrix (reference for the sparse products)
+// Four rows are processed together so every x[j] loaded serves four independent sums; each row is
+// still summed in column order, so the result does not depend on the blocking.
+void dense_matvec(int n_rows, int n_cols, const double* A, const double* x, double* y) {
+    #pragma omp parallel for schedule(static)
+    for (int i0 = 0; i0 < n_rows; i0 += 4) {
+        if (i0 + 4 <= n_rows) {
+            const double* a0 = A + (size_t)i0 * n_cols;
+            const double* a1 = a0 + n_cols;
+            const double* a2 = a1 + n_cols;
+            const double* a3 = a2 + n_cols;
+            double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+            for (int j = 0; j < n_cols; j++) {
+                sum0 += a0[j] * x[j];
+                sum1 += a1[j] * x[j];
+                sum2 += a2[j] * x[j];
+                sum3 += a3[j] * x[j];
+            }
+            y[i0] = sum0;
+            y[i0 + 1] = sum1;
+            y[i0 + 2] = sum2;
+            y[i0 + 3] = sum3;
+        }
+        else {
+            for (int i = i0; i < n_rows; i++) {
+                double sum = 0.0;
+                for (int j = 0; j < n_cols; j++) {
+                    sum += A[(size_t)i * n_cols + j] * x[j];
+                }
+                y[i] = sum;
+            }
+        }
+    }
+}
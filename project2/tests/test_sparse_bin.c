@@ -0,0 +1,116 @@
+// test_sparse_bin.c
+
+// Checks that map_csr_binary accepts a binary CSR file written by write_csr_binary and rejects files
+// whose header was modified, in particular sizes whose section offsets wrap around in 64 bits.
+// Usage: test_sparse_bin [text_matrix_file] [scratch_file]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sparse.h"
+
+// Byte offsets of the header fields patched by the tests (see the layout in sparse_bin.c)
+#define HEADER_N_ROWS 16
+#define HEADER_NNZ 32
+#define HEADER_COL_IDX_OFFSET 64
+#define HEADER_VAL_OFFSET 72
+#define HEADER_FILE_SIZE 80
+#define ROW_PTR_OFFSET 128
+
+typedef struct {
+    const char* name;
+    size_t offset[5];   // byte offsets of the uint64 values to overwrite, 0 ends the list
+    uint64_t value[5];
+} HeaderPatch;
+
+static int write_file(const char* file_name, const char* data, size_t size) {
+    FILE* file = fopen(file_name, "wb");
+    if (file == NULL) {
+        return 1;
+    }
+    int error = fwrite(data, 1, size, file) != size;
+    if (fclose(file) != 0) error = 1;
+    return error;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: test_sparse_bin [text_matrix_file] [scratch_file]\n");
+        return 1;
+    }
+    CooMatrix coo;
+    CsrMatrix A, B;
+    if (read_coo(argv[1], &coo) != 0 || coo_to_csr(&coo, &A) != 0) {
+        return 1;
+    }
+    free_coo(&coo);
+    if (write_csr_binary(argv[2], &A) != 0) {
+        return 1;
+    }
+
+    // Read the written file back to patch copies of it
+    FILE* file = fopen(argv[2], "rb");
+    if (file == NULL) {
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* original = malloc(size);
+    char* patched = malloc(size);
+    if (original == NULL || patched == NULL || fread(original, 1, size, file) != size) {
+        fprintf(stderr, "Error reading '%s'\n", argv[2]);
+        return 1;
+    }
+    fclose(file);
+
+    int failures = 0;
+    if (map_csr_binary(argv[2], &B) != 0 || B.nnz != A.nnz) {
+        printf("FAIL: valid file rejected\n");
+        failures++;
+    }
+    else {
+        printf("PASS: valid file accepted\n");
+        free_csr(&B);
+    }
+
+    // nnz = 2^62 makes nnz * 4 and nnz * 8 wrap to 0, so the offsets of an empty matrix are consistent with it.
+    // With a last row pointer of 2^62 the index check would read far beyond the mapping.
+    uint64_t row_ptr_end = ROW_PTR_OFFSET + (uint64_t)A.n_rows * sizeof(uint64_t);
+    uint64_t col_idx_offset = (row_ptr_end + sizeof(uint64_t) + 63) / 64 * 64;
+    uint64_t wrap = (uint64_t)1 << 62;
+    const HeaderPatch patches[] = {
+        {"nnz wrapping to an empty matrix",
+         {HEADER_NNZ, HEADER_VAL_OFFSET, HEADER_FILE_SIZE, row_ptr_end, 0},
+         {wrap, col_idx_offset, col_idx_offset, wrap, 0}},
+        {"nnz wrapping the value section", {HEADER_NNZ, 0}, {((uint64_t)1 << 61) + 1, 0}},
+        {"nnz larger than the file", {HEADER_NNZ, 0}, {size, 0}},
+        {"row count larger than the file", {HEADER_N_ROWS, 0}, {INT32_MAX, 0}},
+        {"inconsistent section offsets", {HEADER_COL_IDX_OFFSET, 0}, {col_idx_offset + 64, 0}},
+    };
+    for (size_t t = 0; t < sizeof(patches) / sizeof(patches[0]); t++) {
+        memcpy(patched, original, size);
+        for (int k = 0; k < 5 && patches[t].offset[k] != 0; k++) {
+            memcpy(patched + patches[t].offset[k], &patches[t].value[k], sizeof(uint64_t));
+        }
+        if (write_file(argv[2], patched, size) != 0) {
+            fprintf(stderr, "Error writing '%s'\n", argv[2]);
+            return 1;
+        }
+        if (map_csr_binary(argv[2], &B) == 0) {
+            printf("FAIL: %s accepted\n", patches[t].name);
+            free_csr(&B);
+            failures++;
+        }
+        else {
+            printf("PASS: %s rejected\n", patches[t].name);
+        }
+    }
+
+    remove(argv[2]);
+    free(original);
+    free(patched);
+    free_csr(&A);
+    return failures > 0;
+}
@@ -0,0 +1,190 @@
+#include <math.h>
+#include "functions.h"
+#include "analysis.h"
+
+//INITIALISING THE RADIAL DISTRIBUTION FUNCTION
+void rdf_init(Rdf* rdf, double r_max, size_t nbins) {
+	rdf->r_max = r_max;
+	rdf->nbins = nbins;
+	rdf->dr = r_max / nbins;
+	rdf->counts = calloc(nbins, sizeof(unsigned long long));
+	rdf->samples = 0;
+	rdf->density_sum = 0.0;
+	if (rdf->counts == NULL) {
+		printf("Error: Not enough memory for the radial distribution function\n");
+		exit(-1);
+	}
+}
+
+//SAMPLING THE RADIAL DISTRIBUTION FUNCTION
+//Counts one sample of the pairs binned by the force kernel and records the number density, taken from the
+//bounding box of the atoms because the cell has no fixed volume
+void rdf_sample(Rdf* rdf, size_t Natoms, double** coord) {
+	if (Natoms == 0) {
+		return;
+	}
+	double volume = 1.0;
+	for (size_t d = 0; d < 3; d++) {
+		double lo = coord[0][d];
+		double hi = coord[0][d];
+		for (size_t i = 1; i < Natoms; i++) {
+			if (coord[i][d] < lo) lo = coord[i][d];
+			if (coord[i][d] > hi) hi = coord[i][d];
+		}
+		//Atoms in a plane or on a line still occupy a layer of about one atomic diameter
+		volume *= fmax(hi - lo, SIGMA);
+	}
+	rdf->density_sum += Natoms / volume;
+	rdf->samples++;
+}
+
+//WRITING THE RADIAL DISTRIBUTION FUNCTION
+//Writes r, g(r) and the average number of pairs per sample for every bin
+void rdf_write(Rdf* rdf, const char* path, size_t Natoms) {
+	FILE* output_file = fopen(path, "w");
+	if (output_file == NULL) {
+		printf("Error opening output file.\n");
+		exit(-1);
+	}
+	double density = rdf->samples > 0 ? rdf->density_sum / rdf->samples : 0.0;
+	fprintf(output_file, "# Radial distribution function, %zu samples, average density %.6f nm^-3\n", rdf->samples, density);
+	fprintf(output_file, "# r (nm)    g(r)    pairs per sample\n");
+	for (size_t b = 0; b < rdf->nbins; b++) {
+		double r_lo = b * rdf->dr;
+		double r_hi = r_lo + rdf->dr;
+		double shell = 4.0 / 3.0 * M_PI * (pow(r_hi, 3) - pow(r_lo, 3));
+		double pairs = rdf->samples > 0 ? (double)rdf->counts[b] / rdf->samples : 0.0;
+		double ideal = 0.5 * Natoms * density * shell;
+		fprintf(output_file, "%.5f %.6f %.6f\n", r_lo + 0.5 * rdf->dr, ideal > 0.0 ? pairs / ideal : 0.0, pairs);
+	}
+	fclose(output_file);
+}
+
+void rdf_free(Rdf* rdf) {
+	free(rdf->counts);
+	rdf->counts = NULL;
+}
+
+//INITIALISING THE MEAN-SQUARED DISPLACEMENT
+//Stores the starting coordinates as reference
+void msd_init(Msd* msd, size_t Natoms, double** coord) {
+	msd->reference = malloc_2d(Natoms > 0 ? Natoms : 1, 3);
+	if (msd->reference == NULL) {
+		printf("Error: Not enough memory for the mean-squared displacement\n");
+		exit(-1);
+	}
+	for (size_t i = 0; i < Natoms; i++) {
+		for (size_t d = 0; d < 3; d++) {
+			msd->reference[i][d] = coord[i][d];
+		}
+	}
+	msd->nsamples = 0;
+	msd->capacity = 0;
+	msd->steps = NULL;
+	msd->msd = NULL;
+}
+
+//SAMPLING THE MEAN-SQUARED DISPLACEMENT
+void msd_sample(Msd* msd, size_t step, size_t Natoms, double** coord) {
+	if (msd->nsamples == msd->capacity) {
+		msd->capacity = msd->capacity > 0 ? 2 * msd->capacity : 64;
+		msd->steps = realloc(msd->steps, msd->capacity * sizeof(size_t));
+		msd->msd = realloc(msd->msd, msd->capacity * sizeof(double));
+		if (msd->steps == NULL || msd->msd == NULL) {
+			printf("Error: Not enough memory for the mean-squared displacement\n");
+			exit(-1);
+		}
+	}
+	double sum = 0.0;
+	for (size_t i = 0; i < Natoms; i++) {
+		for (size_t d = 0; d < 3; d++) {
+			double dx = coord[i][d] - msd->reference[i][d];
+			sum += dx * dx;
+		}
+	}
+	msd->steps[msd->nsamples] = step;
+	msd->msd[msd->nsamples] = Natoms > 0 ? sum / Natoms : 0.0;
+	msd->nsamples++;
+}
+
+//WRITING THE MEAN-SQUARED DISPLACEMENT
+void msd_write(Msd* msd, const char* path, double dt) {
+	FILE* output_file = fopen(path, "w");
+	if (output_file == NULL) {
+		printf("Error opening output file.\n");
+		exit(-1);
+	}
+	fprintf(output_file, "# Mean-squared displacement\n");
+	fprintf(output_file, "# step    time    MSD (nm^2)\n");
+	for (size_t k = 0; k < msd->nsamples; k++) {
+		fprintf(output_file, "%zu %.4f %.8f\n", msd->steps[k], msd->steps[k] * dt, msd->msd[k]);
+	}
+	fclose(output_file);
+}
+
+void msd_free(Msd* msd) {
+	free_2d(msd->reference);
+	free(msd->steps);
+	free(msd->msd);
+	msd->reference = NULL;
+	msd->steps = NULL;
+	msd->msd = NULL;
+}
+
+//INITIALISING THE ENERGY STATISTICS
+void energy_stats_init(EnergyStats* stats) {
+	stats->n = 0;
+	stats->mean_T = stats->mean_V = stats->mean_E = 0.0;
+	stats->m2_T = stats->m2_V = stats->m2_E = 0.0;
+	stats->mean_t = stats->m2_t = stats->cov_tE = 0.0;
+	stats->first_E = stats->last_E = 0.0;
+}
+
+//SAMPLING THE ENERGIES
+//Welford updates of the means and squared deviations, which stay accurate over long runs
+void energy_stats_sample(EnergyStats* stats, double time, double kin_E, double pot_E, double tot_E) {
+	stats->n++;
+	double n = (double)stats->n;
+
+	double d_T = kin_E - stats->mean_T;
+	stats->mean_T += d_T / n;
+	stats->m2_T += d_T * (kin_E - stats->mean_T);
+
+	double d_V = pot_E - stats->mean_V;
+	stats->mean_V += d_V / n;
+	stats->m2_V += d_V * (pot_E - stats->mean_V);
+
+	double d_t = time - stats->mean_t;
+	stats->mean_t += d_t / n;
+	stats->m2_t += d_t * (time - stats->mean_t);
+
+	double d_E = tot_E - stats->mean_E;
+	stats->mean_E += d_E / n;
+	stats->m2_E += d_E * (tot_E - stats->mean_E);
+	stats->cov_tE += d_t * (tot_E - stats->mean_E);
+
+	if (stats->n == 1) {
+		stats->first_E = tot_E;
+	}
+	stats->last_E = tot_E;
+}
+
+//WRITING THE ENERGY STATISTICS
+//Averages and standard deviations of the energies, the drift of the total energy (slope of the least-squares fit
+//of E against time) and the relative change of the total energy over the run
+void energy_stats_write(EnergyStats* stats, const char* path) {
+	FILE* output_file = fopen(path, "w");
+	if (output_file == NULL) {
+		printf("Error opening output file.\n");
+		exit(-1);
+	}
+	double n = stats->n > 0 ? (double)stats->n : 1.0;
+	double drift = stats->m2_t > 0.0 ? stats->cov_tE / stats->m2_t : 0.0;
+	fprintf(output_file, "Samples: %zu\n", stats->n);
+	fprintf(output_file, "Kinetic energy: average = %.6f, standard deviation = %.6f\n", stats->mean_T, sqrt(stats->m2_T / n));
+	fprintf(output_file, "Potential energy: average = %.6f, standard deviation = %.6f\n", stats->mean_V, sqrt(stats->m2_V / n));
+	fprintf(output_file, "Total energy: average = %.6f, standard deviation = %.6f\n", stats->mean_E, sqrt(stats->m2_E / n));
+	fprintf(output_file, "Total energy drift: %.6e per time unit\n", drift);
+	fprintf(output_file, "Relative total energy change: %.6e\n", stats->first_E != 0.0 ? (stats->last_E - stats->first_E) / fabs(stats->first_E) : 0.0);
+	fclose(output_file);
+}
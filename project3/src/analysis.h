@@ -0,0 +1,63 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+#include <stdio.h>
+#include <stdlib.h>
+
+//Range (nm) and number of bins of the radial distribution function
+#define RDF_RMAX (5 * SIGMA)
+#define RDF_BINS 100
+
+//RADIAL DISTRIBUTION FUNCTION
+//Histogram of the pair distances, filled by the force kernel while it loops over the pairs
+typedef struct {
+	double r_max;
+	double dr;
+	size_t nbins;
+	unsigned long long* counts;  //Pairs per bin, summed over all samples
+	size_t samples;
+	double density_sum;          //Sum of the number densities of the samples
+} Rdf;
+
+//Adds one pair distance to the histogram. r / dr can round up to nbins for r just below r_max, so the index is
+//clamped to the last bin
+static inline void rdf_add(Rdf* rdf, double r) {
+	if (r < rdf->r_max) {
+		size_t bin = (size_t)(r / rdf->dr);
+		rdf->counts[bin < rdf->nbins ? bin : rdf->nbins - 1]++;
+	}
+}
+
+void rdf_init(Rdf* rdf, double r_max, size_t nbins);
+void rdf_sample(Rdf* rdf, size_t Natoms, double** coord);
+void rdf_write(Rdf* rdf, const char* path, size_t Natoms);
+void rdf_free(Rdf* rdf);
+
+//MEAN-SQUARED DISPLACEMENT
+//Displacements are measured from the initial coordinates, which are never wrapped as the cell has no periodic boundaries
+typedef struct {
+	double** reference;
+	size_t nsamples, capacity;
+	size_t* steps;
+	double* msd;
+} Msd;
+
+void msd_init(Msd* msd, size_t Natoms, double** coord);
+void msd_sample(Msd* msd, size_t step, size_t Natoms, double** coord);
+void msd_write(Msd* msd, const char* path, double dt);
+void msd_free(Msd* msd);
+
+//ENERGY STATISTICS
+//Running averages and fluctuations of the energies and a running least-squares fit of the total energy drift
+typedef struct {
+	size_t n;
+	double mean_T, mean_V, mean_E;
+	double m2_T, m2_V, m2_E;     //Sums of squared deviations from the mean
+	double mean_t, m2_t, cov_tE; //For the slope of E(t)
+	double first_E, last_E;
+} EnergyStats;
+
+void energy_stats_init(EnergyStats* stats);
+void energy_stats_sample(EnergyStats* stats, double time, double kin_E, double pot_E, double tot_E);
+void energy_stats_write(EnergyStats* stats, const char* path);
+
+#endif
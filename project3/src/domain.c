@@ -0,0 +1,466 @@
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "functions.h"
+#include "domain.h"
+
+//Number of doubles sent for a migrating atom (gid, coordinates, velocity, acceleration, mass), a ghost atom (gid,
+//coordinates) and an atom gathered on rank 0 (gid, coordinates, velocity, acceleration)
+#define ATOM_DOUBLES 11
+#define GHOST_DOUBLES 4
+#define GATHER_DOUBLES 10
+
+//Stops all ranks with an error message
+static void domain_error(const char* message) {
+	printf("%s\n", message);
+	MPI_Abort(MPI_COMM_WORLD, -1);
+}
+
+static void* domain_realloc(void* a, size_t size) {
+	void* b = realloc(a, size > 0 ? size : 1);
+	if (b == NULL) {
+		domain_error("Error: Not enough memory for the domain decomposition");
+	}
+	return b;
+}
+
+//Grows the arrays of owned atoms to hold at least n atoms
+static void reserve_atoms(Domain* dom, size_t n) {
+	if (n <= dom->capacity) {
+		return;
+	}
+	size_t capacity = dom->capacity > 0 ? dom->capacity : 64;
+	while (capacity < n) capacity *= 2;
+	dom->gid = domain_realloc(dom->gid, capacity * sizeof(double));
+	dom->coord = domain_realloc(dom->coord, 3 * capacity * sizeof(double));
+	dom->velocity = domain_realloc(dom->velocity, 3 * capacity * sizeof(double));
+	dom->acceleration = domain_realloc(dom->acceleration, 3 * capacity * sizeof(double));
+	dom->mass = domain_realloc(dom->mass, capacity * sizeof(double));
+	dom->capacity = capacity;
+}
+
+//Grows the arrays of ghost atoms to hold at least n atoms
+static void reserve_ghosts(Domain* dom, size_t n) {
+	if (n <= dom->ghost_capacity) {
+		return;
+	}
+	size_t capacity = dom->ghost_capacity > 0 ? dom->ghost_capacity : 64;
+	while (capacity < n) capacity *= 2;
+	dom->ghost_gid = domain_realloc(dom->ghost_gid, capacity * sizeof(double));
+	dom->ghost_coord = domain_realloc(dom->ghost_coord, 3 * capacity * sizeof(double));
+	dom->ghost_capacity = capacity;
+}
+
+//Rank owning the slab that contains position x along the decomposition axis
+static int owner(Domain* dom, double x) {
+	int lo = 0;
+	int hi = dom->nranks - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (dom->bounds[mid] <= x) {
+			lo = mid;
+		}
+		else {
+			hi = mid - 1;
+		}
+	}
+	return lo;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+//EXCHANGING PACKED DATA BETWEEN ALL RANKS
+//send holds the packed items of `size` doubles for every rank in rank order, send_counts the number of items for
+//every rank and type the MPI datatype of one item. Counts and displacements are in items, so they fit in an int as
+//long as the number of atoms does. Returns the received doubles (to be freed by the caller) and the number of
+//received items in *nrecv
+static double* exchange(Domain* dom, double* send, int* send_counts, MPI_Datatype type, size_t size, size_t* nrecv) {
+	int P = dom->nranks;
+	int* recv_counts = malloc(P * sizeof(int));
+	int* send_displs = malloc(P * sizeof(int));
+	int* recv_displs = malloc(P * sizeof(int));
+	if (recv_counts == NULL || send_displs == NULL || recv_displs == NULL) {
+		domain_error("Error: Not enough memory for the domain decomposition");
+	}
+	MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, dom->comm);
+
+	size_t total = 0;
+	size_t offset = 0;
+	for (int r = 0; r < P; r++) {
+		if (offset > INT_MAX || total > INT_MAX) {
+			domain_error("Error: Too many atoms for the MPI exchange");
+		}
+		send_displs[r] = (int)offset;
+		offset += send_counts[r];
+		recv_displs[r] = (int)total;
+		total += recv_counts[r];
+	}
+	double* recv = domain_realloc(NULL, total * size * sizeof(double));
+	MPI_Alltoallv(send, send_counts, send_displs, type, recv, recv_counts, recv_displs, type, dom->comm);
+
+	free(recv_counts);
+	free(send_displs);
+	free(recv_displs);
+	*nrecv = total;
+	return recv;
+}
+
+//INITIALISING THE DOMAIN DECOMPOSITION
+//Rank 0 passes all atoms (the other ranks pass NULL arrays), cuts the cell in slabs with the same number of atoms
+//along its longest axis and sends every atom to the rank owning it. Velocities and accelerations start at zero
+void domain_init(Domain* dom, MPI_Comm comm, size_t Natoms, double** coord, double* mass) {
+	memset(dom, 0, sizeof(Domain));
+	dom->comm = comm;
+	MPI_Comm_rank(comm, &dom->rank);
+	MPI_Comm_size(comm, &dom->nranks);
+	if (Natoms > INT_MAX) {
+		domain_error("Error: Too many atoms for the MPI exchange");
+	}
+	MPI_Type_contiguous(ATOM_DOUBLES, MPI_DOUBLE, &dom->atom_type);
+	MPI_Type_contiguous(GHOST_DOUBLES, MPI_DOUBLE, &dom->ghost_type);
+	MPI_Type_contiguous(GATHER_DOUBLES, MPI_DOUBLE, &dom->gather_type);
+	MPI_Type_commit(&dom->atom_type);
+	MPI_Type_commit(&dom->ghost_type);
+	MPI_Type_commit(&dom->gather_type);
+	dom->halo = CUTOFF > 0.0 ? CUTOFF : INFINITY;
+	dom->bounds = domain_realloc(NULL, (dom->nranks + 1) * sizeof(double));
+
+	if (dom->rank == 0) {
+		//Longest axis of the bounding box of the atoms
+		double extent[3] = {0.0, 0.0, 0.0};
+		for (int d = 0; d < 3 && Natoms > 0; d++) {
+			double lo = coord[0][d];
+			double hi = coord[0][d];
+			for (size_t i = 1; i < Natoms; i++) {
+				if (coord[i][d] < lo) lo = coord[i][d];
+				if (coord[i][d] > hi) hi = coord[i][d];
+			}
+			extent[d] = hi - lo;
+		}
+		dom->axis = 0;
+		for (int d = 1; d < 3; d++) {
+			if (extent[d] > extent[dom->axis]) dom->axis = d;
+		}
+
+		//Slab boundaries halfway between the atoms that split the sorted positions in equal parts. With more ranks
+		//than atoms some slabs are empty (bounds[r] = bounds[r - 1]), the boundaries never decrease
+		double* x = domain_realloc(NULL, Natoms * sizeof(double));
+		for (size_t i = 0; i < Natoms; i++) {
+			x[i] = coord[i][dom->axis];
+		}
+		qsort(x, Natoms, sizeof(double), compare_doubles);
+		dom->bounds[0] = -INFINITY;
+		dom->bounds[dom->nranks] = INFINITY;
+		for (int r = 1; r < dom->nranks; r++) {
+			size_t k = Natoms * r / dom->nranks;
+			if (k == 0) {
+				dom->bounds[r] = dom->bounds[r - 1];
+			}
+			else {
+				dom->bounds[r] = 0.5 * (x[k - 1] + x[k]);
+			}
+		}
+		free(x);
+
+		reserve_atoms(dom, Natoms);
+		for (size_t i = 0; i < Natoms; i++) {
+			dom->gid[i] = (double)i;
+			dom->mass[i] = mass[i];
+			for (int d = 0; d < 3; d++) {
+				dom->coord[3 * i + d] = coord[i][d];
+				dom->velocity[3 * i + d] = 0.0;
+				dom->acceleration[3 * i + d] = 0.0;
+			}
+		}
+		dom->n = Natoms;
+	}
+	MPI_Bcast(&dom->axis, 1, MPI_INT, 0, comm);
+	MPI_Bcast(dom->bounds, dom->nranks + 1, MPI_DOUBLE, 0, comm);
+
+	domain_migrate(dom);
+}
+
+void domain_free(Domain* dom) {
+	free(dom->bounds);
+	free(dom->gid);
+	free(dom->coord);
+	free(dom->velocity);
+	free(dom->acceleration);
+	free(dom->mass);
+	free(dom->ghost_gid);
+	free(dom->ghost_coord);
+	MPI_Type_free(&dom->atom_type);
+	MPI_Type_free(&dom->ghost_type);
+	MPI_Type_free(&dom->gather_type);
+	memset(dom, 0, sizeof(Domain));
+}
+
+//MIGRATING ATOMS
+//Sends the atoms that left the slab of this rank, with their velocity, acceleration and mass, to their new owner
+void domain_migrate(Domain* dom) {
+	int P = dom->nranks;
+	int* send_counts = calloc(P, sizeof(int));
+	int* dest = malloc((dom->n > 0 ? dom->n : 1) * sizeof(int));
+	if (send_counts == NULL || dest == NULL) {
+		domain_error("Error: Not enough memory for the domain decomposition");
+	}
+
+	size_t nsend = 0;
+	for (size_t i = 0; i < dom->n; i++) {
+		double x = dom->coord[3 * i + dom->axis];
+		dest[i] = (x >= dom->bounds[dom->rank] && x < dom->bounds[dom->rank + 1]) ? dom->rank : owner(dom, x);
+		if (dest[i] != dom->rank) {
+			send_counts[dest[i]]++;
+			nsend++;
+		}
+	}
+
+	//Pack the leaving atoms in rank order and compact the ones that stay
+	size_t* offset = malloc(P * sizeof(size_t));
+	double* send = domain_realloc(NULL, nsend * ATOM_DOUBLES * sizeof(double));
+	if (offset == NULL) {
+		domain_error("Error: Not enough memory for the domain decomposition");
+	}
+	offset[0] = 0;
+	for (int r = 1; r < P; r++) {
+		offset[r] = offset[r - 1] + send_counts[r - 1];
+	}
+	size_t kept = 0;
+	for (size_t i = 0; i < dom->n; i++) {
+		if (dest[i] != dom->rank) {
+			double* p = send + offset[dest[i]] * ATOM_DOUBLES;
+			p[0] = dom->gid[i];
+			memcpy(p + 1, dom->coord + 3 * i, 3 * sizeof(double));
+			memcpy(p + 4, dom->velocity + 3 * i, 3 * sizeof(double));
+			memcpy(p + 7, dom->acceleration + 3 * i, 3 * sizeof(double));
+			p[10] = dom->mass[i];
+			offset[dest[i]]++;
+			continue;
+		}
+		if (kept != i) {
+			dom->gid[kept] = dom->gid[i];
+			memcpy(dom->coord + 3 * kept, dom->coord + 3 * i, 3 * sizeof(double));
+			memcpy(dom->velocity + 3 * kept, dom->velocity + 3 * i, 3 * sizeof(double));
+			memcpy(dom->acceleration + 3 * kept, dom->acceleration + 3 * i, 3 * sizeof(double));
+			dom->mass[kept] = dom->mass[i];
+		}
+		kept++;
+	}
+	dom->n = kept;
+
+	size_t nrecv;
+	double* recv = exchange(dom, send, send_counts, dom->atom_type, ATOM_DOUBLES, &nrecv);
+	size_t arrived = nrecv;
+	reserve_atoms(dom, dom->n + arrived);
+	for (size_t k = 0; k < arrived; k++) {
+		double* p = recv + k * ATOM_DOUBLES;
+		size_t i = dom->n + k;
+		dom->gid[i] = p[0];
+		memcpy(dom->coord + 3 * i, p + 1, 3 * sizeof(double));
+		memcpy(dom->velocity + 3 * i, p + 4, 3 * sizeof(double));
+		memcpy(dom->acceleration + 3 * i, p + 7, 3 * sizeof(double));
+		dom->mass[i] = p[10];
+	}
+	dom->n += arrived;
+
+	free(recv);
+	free(send);
+	free(offset);
+	free(dest);
+	free(send_counts);
+}
+
+//EXCHANGING HALO ATOMS
+//Every rank sends the coordinates of its atoms that are within the cutoff of the slab of another rank. The slabs
+//are ordered along the axis, so only the neighbouring ranks up to the cutoff distance are visited
+void domain_exchange_halo(Domain* dom) {
+	int P = dom->nranks;
+	int* send_counts = calloc(P, sizeof(int));
+	if (send_counts == NULL) {
+		domain_error("Error: Not enough memory for the domain decomposition");
+	}
+	for (size_t i = 0; i < dom->n; i++) {
+		double x = dom->coord[3 * i + dom->axis];
+		for (int r = dom->rank - 1; r >= 0 && x - dom->bounds[r + 1] <= dom->halo; r--) {
+			send_counts[r]++;
+		}
+		for (int r = dom->rank + 1; r < P && dom->bounds[r] - x <= dom->halo; r++) {
+			send_counts[r]++;
+		}
+	}
+
+	size_t* offset = malloc(P * sizeof(size_t));
+	if (offset == NULL) {
+		domain_error("Error: Not enough memory for the domain decomposition");
+	}
+	offset[0] = 0;
+	for (int r = 1; r < P; r++) {
+		offset[r] = offset[r - 1] + send_counts[r - 1];
+	}
+	double* send = domain_realloc(NULL, (offset[P - 1] + send_counts[P - 1]) * GHOST_DOUBLES * sizeof(double));
+	for (size_t i = 0; i < dom->n; i++) {
+		double x = dom->coord[3 * i + dom->axis];
+		for (int r = dom->rank - 1; r >= 0 && x - dom->bounds[r + 1] <= dom->halo; r--) {
+			send[offset[r] * GHOST_DOUBLES] = dom->gid[i];
+			memcpy(send + offset[r] * GHOST_DOUBLES + 1, dom->coord + 3 * i, 3 * sizeof(double));
+			offset[r]++;
+		}
+		for (int r = dom->rank + 1; r < P && dom->bounds[r] - x <= dom->halo; r++) {
+			send[offset[r] * GHOST_DOUBLES] = dom->gid[i];
+			memcpy(send + offset[r] * GHOST_DOUBLES + 1, dom->coord + 3 * i, 3 * sizeof(double));
+			offset[r]++;
+		}
+	}
+
+	size_t nrecv;
+	double* recv = exchange(dom, send, send_counts, dom->ghost_type, GHOST_DOUBLES, &nrecv);
+	dom->n_ghost = nrecv;
+	reserve_ghosts(dom, dom->n_ghost);
+	for (size_t k = 0; k < dom->n_ghost; k++) {
+		dom->ghost_gid[k] = recv[k * GHOST_DOUBLES];
+		memcpy(dom->ghost_coord + 3 * k, recv + k * GHOST_DOUBLES + 1, 3 * sizeof(double));
+	}
+
+	free(recv);
+	free(send);
+	free(offset);
+	free(send_counts);
+}
+
+//Lennard-Jones contribution of atom j (at position xj) to the acceleration of owned atom i, same pair term as compute_acc
+static void add_acc(Domain* dom, size_t i, const double* xj) {
+	const double* xi = dom->coord + 3 * i;
+	double dx = xi[0] - xj[0];
+	double dy = xi[1] - xj[1];
+	double dz = xi[2] - xj[2];
+	double r = sqrt(dx * dx + dy * dy + dz * dz);
+	if (CUTOFF > 0.0 && r > CUTOFF) return;
+
+	double U = lj_force(r);
+
+	for (int d = 0; d < 3; d++) {
+		dom->acceleration[3 * i + d] -= U * (xi[d] - xj[d]) / (dom->mass[i] * r);
+	}
+}
+
+//COMPUTE ACCELERATION
+//Accelerations of the owned atoms from the owned and ghost atoms, requires an up to date halo
+void domain_compute_acc(Domain* dom) {
+	for (size_t i = 0; i < dom->n; i++) {
+		for (int d = 0; d < 3; d++) {
+			dom->acceleration[3 * i + d] = 0.0;
+		}
+		for (size_t j = 0; j < dom->n; j++) {
+			if (i == j) continue; //No self-interaction
+			add_acc(dom, i, dom->coord + 3 * j);
+		}
+		for (size_t j = 0; j < dom->n_ghost; j++) {
+			add_acc(dom, i, dom->ghost_coord + 3 * j);
+		}
+	}
+}
+
+//Lennard-Jones energy of a pair, exits if both atoms are in the same position
+static double pair_V(const double* xi, const double* xj) {
+	double dx = xi[0] - xj[0];
+	double dy = xi[1] - xj[1];
+	double dz = xi[2] - xj[2];
+	double r = sqrt(dx * dx + dy * dy + dz * dz);
+	if (r == 0.0) {
+		domain_error("Error: Multiple atoms in the same position");
+	}
+	return lj_potential(r);
+}
+
+//COMPUTE ENERGIES
+//Global kinetic and potential energy. A pair is counted by the rank owning the atom with the lower global index,
+//so every pair enters the reduction exactly once. Requires an up to date halo
+void domain_energies(Domain* dom, double* kin_E, double* pot_E) {
+	double local[2] = {0.0, 0.0};
+	for (size_t i = 0; i < dom->n; i++) {
+		const double* v = dom->velocity + 3 * i;
+		local[0] += 0.5 * dom->mass[i] * (pow(v[0], 2) + pow(v[1], 2) + pow(v[2], 2));
+
+		for (size_t j = 0; j < dom->n; j++) {
+			if (dom->gid[i] < dom->gid[j]) {
+				local[1] += pair_V(dom->coord + 3 * i, dom->coord + 3 * j);
+			}
+		}
+		for (size_t j = 0; j < dom->n_ghost; j++) {
+			if (dom->gid[i] < dom->ghost_gid[j]) {
+				local[1] += pair_V(dom->coord + 3 * i, dom->ghost_coord + 3 * j);
+			}
+		}
+	}
+	double global[2];
+	MPI_Allreduce(local, global, 2, MPI_DOUBLE, MPI_SUM, dom->comm);
+	*kin_E = global[0];
+	*pot_E = global[1];
+}
+
+//UPDATING THE POSITIONS FOR THE VERLET ALGORITHM
+void domain_update_position(Domain* dom, double dt) {
+	for (size_t k = 0; k < 3 * dom->n; k++) {
+		dom->coord[k] += dom->velocity[k] * dt + 0.5 * dom->acceleration[k] * pow(dt, 2);
+	}
+}
+
+//UPDATING THE VELOCITIES FOR THE VERLET ALGORITHM
+void domain_update_velocity(Domain* dom, double dt) {
+	for (size_t k = 0; k < 3 * dom->n; k++) {
+		dom->velocity[k] += 0.5 * dom->acceleration[k] * dt;
+	}
+}
+
+//GATHERING ALL ATOMS ON RANK 0
+//Collects coordinates, velocities and accelerations of all atoms in the input order into the Natoms x 3 arrays
+//of rank 0 (the other ranks pass NULL). Counts and displacements are in atoms of GATHER_DOUBLES doubles
+void domain_gather(Domain* dom, size_t Natoms, double** coord, double** velocity, double** acceleration) {
+	int P = dom->nranks;
+	int count = (int)dom->n;
+	double* send = domain_realloc(NULL, dom->n * GATHER_DOUBLES * sizeof(double));
+	for (size_t i = 0; i < dom->n; i++) {
+		send[GATHER_DOUBLES * i] = dom->gid[i];
+		memcpy(send + GATHER_DOUBLES * i + 1, dom->coord + 3 * i, 3 * sizeof(double));
+		memcpy(send + GATHER_DOUBLES * i + 4, dom->velocity + 3 * i, 3 * sizeof(double));
+		memcpy(send + GATHER_DOUBLES * i + 7, dom->acceleration + 3 * i, 3 * sizeof(double));
+	}
+
+	int* counts = NULL;
+	int* displs = NULL;
+	double* recv = NULL;
+	if (dom->rank == 0) {
+		counts = malloc(P * sizeof(int));
+		displs = malloc(P * sizeof(int));
+		recv = domain_realloc(NULL, Natoms * GATHER_DOUBLES * sizeof(double));
+		if (counts == NULL || displs == NULL) {
+			domain_error("Error: Not enough memory for the domain decomposition");
+		}
+	}
+	MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, dom->comm);
+	if (dom->rank == 0) {
+		displs[0] = 0;
+		for (int r = 1; r < P; r++) {
+			displs[r] = displs[r - 1] + counts[r - 1];
+		}
+	}
+	MPI_Gatherv(send, count, dom->gather_type, recv, counts, displs, dom->gather_type, 0, dom->comm);
+
+	if (dom->rank == 0) {
+		for (size_t k = 0; k < Natoms; k++) {
+			const double* p = recv + GATHER_DOUBLES * k;
+			size_t i = (size_t)p[0];
+			memcpy(coord[i], p + 1, 3 * sizeof(double));
+			memcpy(velocity[i], p + 4, 3 * sizeof(double));
+			memcpy(acceleration[i], p + 7, 3 * sizeof(double));
+		}
+	}
+	free(recv);
+	free(displs);
+	free(counts);
+	free(send);
+}
@@ -0,0 +1,42 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+//Spatial domain decomposition: the simulation cell is cut in slabs along one axis and every rank owns the atoms
+//in its slab. Owned atoms are stored in flat arrays (3 doubles per atom for vectors), ghost atoms are copies of
+//the atoms of other ranks within the cutoff of the slab
+typedef struct {
+	MPI_Comm comm;
+	int rank, nranks;
+	int axis;            //Axis along which the cell is cut
+	double* bounds;      //nranks+1 slab boundaries, the outer ones are -/+ infinity
+	double halo;         //Halo width (cutoff radius, infinity without cutoff)
+
+	size_t n, capacity;  //Owned atoms
+	double* gid;         //Global atom index (position in the input file), stored as a double for MPI transfers
+	double* coord;
+	double* velocity;
+	double* acceleration;
+	double* mass;
+
+	size_t n_ghost, ghost_capacity;
+	double* ghost_gid;
+	double* ghost_coord;
+
+	//One migrating, ghost or gathered atom as a single MPI element, so the counts passed to MPI are atoms
+	MPI_Datatype atom_type, ghost_type, gather_type;
+} Domain;
+
+void domain_init(Domain* dom, MPI_Comm comm, size_t Natoms, double** coord, double* mass);
+void domain_free(Domain* dom);
+void domain_migrate(Domain* dom);
+void domain_exchange_halo(Domain* dom);
+void domain_compute_acc(Domain* dom);
+void domain_energies(Domain* dom, double* kin_E, double* pot_E);
+void domain_update_position(Domain* dom, double dt);
+void domain_update_velocity(Domain* dom, double dt);
+void domain_gather(Domain* dom, size_t Natoms, double** coord, double** velocity, double** acceleration);
+
+#endif
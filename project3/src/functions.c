@@ -26,36 +26,24 @@ void free_2d(double** a) {
 	free(a);
 }
 
-//READING NUMBER OF ATOMS
-//Check if the input file was opened correctly, exit the program with an error code otherwise
-size_t read_Natoms(FILE* input_file) {
-    if (input_file == NULL) {
-        printf("Error opening input file\n");
-        exit(-1);
-    }
-
-//Read the number of atoms from the first line
-    size_t number_of_atoms;
-    int read_number = fscanf(input_file, "%zu", &number_of_atoms);
-    if (read_number != 1) {
-        printf("Error: Not a valid number of atoms\n");
-        exit(-1);
-    }
-
-    return number_of_atoms;
+//LENNARD-JONES PAIR TERMS
+//Potential energy of a pair of atoms at distance r, 0 beyond the cutoff. Shared by the serial and the MPI version
+double lj_potential(double r) {
+	if (CUTOFF > 0.0 && r > CUTOFF) return 0.0;
+	double s_r = SIGMA /r;
+	double s_r_6 = pow(s_r, 6);
+	double s_r_12 = pow(s_r, 12);
+	return 4 * EPSILON * (s_r_12 - s_r_6);
 }
 
-//READING COORDINATES AND MASS
-//Read coordinates and mass from the input file
-void read_molecule(FILE* input_file, size_t Natoms, double** coord, double* mass) {
-    for (size_t i = 0; i < Natoms; i++) {
-        int read_number = fscanf(input_file, "%lf %lf %lf %lf", &coord[i][0], &coord[i][1], &coord[i][2], &mass[i]);
-//Exit the program if the number of columns in the input file is different than 4
-	if (read_number != 4) {
-            printf("Error: Couldn't read mass and coordinates\n");
-            exit(-1);
-        }
-    }
+//Derivative dV/dr of the pair potential at distance r, 0 beyond the cutoff. Atom i is accelerated by
+//-lj_force(r) * (x_i - x_j) / (m_i * r)
+double lj_force(double r) {
+	if (CUTOFF > 0.0 && r > CUTOFF) return 0.0;
+	double s_r = SIGMA /r;
+	double s_r_6 = pow(s_r, 6);
+	double s_r_12 = pow(s_r, 12);
+	return 24 * EPSILON * (s_r_6 - 2 * s_r_12)/r;
 }
 
 //COMPUTE DISTANCES BETWEEN ATOMS
@@ -88,13 +76,8 @@ double V(size_t Natoms, double** distance) {
 				printf("Error: Multiple atoms in the same position\n");
         			exit(-1);
 			}
-			double s_r = SIGMA /r;
-			double s_r_6 = pow(s_r, 6);
-			double s_r_12 = pow(s_r, 12);
-	
-			double V_lj = 4 * EPSILON * (s_r_12 - s_r_6);
-
-			pot_E += V_lj;
+			if (CUTOFF > 0.0 && r > CUTOFF) continue;
+			pot_E += lj_potential(r);
 		}
 	}
 	return pot_E;
@@ -124,7 +107,8 @@ double E(size_t Natoms, double** distance, double** velocity, double* mass) {
 
 //COMPUTE ACCELERATION
 //Calculates acceleration vectors for each atom
-void compute_acc(size_t Natoms, double** coord, double* mass, double** distance, double** acceleration) {
+//Pair distances are added to the radial distribution function if rdf is not NULL
+void compute_acc(size_t Natoms, double** coord, double* mass, double** distance, double** acceleration, Rdf* rdf) {
         for (size_t i = 0; i < Natoms; i++) {
 		for (size_t d =0; d < 3; d++) {
 			acceleration[i][d] = 0.0;
@@ -134,12 +118,10 @@ void compute_acc(size_t Natoms, double** coord, double* mass, double** distance,
 			if (i == j) continue; //No self-interaction
 
                         double r = distance[i][j];
+			if (rdf != NULL && j > i) rdf_add(rdf, r);
+			if (CUTOFF > 0.0 && r > CUTOFF) continue;
 
-                        double s_r = SIGMA /r;
-                        double s_r_6 = pow(s_r, 6);
-                        double s_r_12 = pow(s_r, 12);
-
-                        double U = 24 * EPSILON * (s_r_6 - 2 * s_r_12)/r;
+                        double U = lj_force(r);
 
 			for (size_t d = 0; d < 3; d++) {
                         	acceleration[i][d] -= U * (coord[i][d] - coord[j][d]) / (mass[i] * r);
@@ -148,6 +130,99 @@ void compute_acc(size_t Natoms, double** coord, double* mass, double** distance,
         }
 }
 
+//Single-precision part of compute_acc_mixed: adds the interactions of atom i with atoms begin..end-1 to (ax, ay, az).
+//All arithmetic is in float so the loop vectorises with twice as many lanes. The pair forces are summed in float over
+//blocks of MIXED_BLOCK atoms, and every block sum is added to the double precision sums. If rdf is not NULL the pair
+//distances of the block are added to the radial distribution function after the block, as in compute_acc
+static void acc_mixed_range(float xi, float yi, float zi, const float* x, const float* y, const float* z, size_t begin, size_t end, double* ax, double* ay, double* az, Rdf* rdf) {
+	const float sigma_2 = (float)(SIGMA * SIGMA);
+	const float cutoff_2 = (float)(CUTOFF * CUTOFF);
+	const float eps_24 = (float)(24 * EPSILON);
+	double sx = 0.0, sy = 0.0, sz = 0.0;
+	for (size_t block = begin; block < end; block += MIXED_BLOCK) {
+		size_t block_end = end - block > MIXED_BLOCK ? block + MIXED_BLOCK : end;
+		float bx = 0.0f, by = 0.0f, bz = 0.0f;
+		float block_r_2[MIXED_BLOCK];
+		#pragma omp simd reduction(+:bx,by,bz)
+		for (size_t j = block; j < block_end; j++) {
+			float dx = xi - x[j];
+			float dy = yi - y[j];
+			float dz = zi - z[j];
+			float r_2 = dx * dx + dy * dy + dz * dz;
+			block_r_2[j - block] = r_2;
+			float inv_r_2 = 1.0f / r_2;
+			float s_r_2 = sigma_2 * inv_r_2;
+			float s_r_6 = s_r_2 * s_r_2 * s_r_2;
+			float s_r_12 = s_r_6 * s_r_6;
+			float f = eps_24 * (2.0f * s_r_12 - s_r_6) * inv_r_2;
+			if (CUTOFF > 0.0 && r_2 > cutoff_2) f = 0.0f;
+			bx += f * dx;
+			by += f * dy;
+			bz += f * dz;
+		}
+		sx += bx;
+		sy += by;
+		sz += bz;
+		if (rdf != NULL) {
+			for (size_t k = 0; k < block_end - block; k++) {
+				rdf_add(rdf, sqrt(block_r_2[k]));
+			}
+		}
+	}
+	*ax += sx;
+	*ay += sy;
+	*az += sz;
+}
+
+//COMPUTE ACCELERATION IN MIXED PRECISION
+//Same forces as compute_acc, computed from the coordinates instead of the distance matrix: distances, inverse powers
+//and pair forces in single precision, accumulation of the forces and accelerations in double precision. The
+//coordinates are shifted to the centre of the atoms before rounding to float to keep the differences accurate.
+//coord_f is a buffer of 3 * Natoms floats allocated once by the caller (see malloc_mixed) and reused on every call
+void compute_acc_mixed(size_t Natoms, double** coord, double* mass, float* coord_f, double** acceleration, Rdf* rdf) {
+	float* x = coord_f;
+	float* y = x + Natoms;
+	float* z = y + Natoms;
+
+	double center[3] = {0.0, 0.0, 0.0};
+	for (size_t d = 0; d < 3 && Natoms > 0; d++) {
+		double lo = coord[0][d];
+		double hi = coord[0][d];
+		for (size_t i = 1; i < Natoms; i++) {
+			if (coord[i][d] < lo) lo = coord[i][d];
+			if (coord[i][d] > hi) hi = coord[i][d];
+		}
+		center[d] = 0.5 * (lo + hi);
+	}
+	for (size_t i = 0; i < Natoms; i++) {
+		x[i] = (float)(coord[i][0] - center[0]);
+		y[i] = (float)(coord[i][1] - center[1]);
+		z[i] = (float)(coord[i][2] - center[2]);
+	}
+
+	for (size_t i = 0; i < Natoms; i++) {
+		double ax = 0.0, ay = 0.0, az = 0.0;
+		//No self-interaction: the pairs before and after atom i are computed separately
+		//Every pair is added to the radial distribution function once, from the atom with the lower index
+		acc_mixed_range(x[i], y[i], z[i], x, y, z, 0, i, &ax, &ay, &az, NULL);
+		acc_mixed_range(x[i], y[i], z[i], x, y, z, i + 1, Natoms, &ax, &ay, &az, rdf);
+		acceleration[i][0] = ax / mass[i];
+		acceleration[i][1] = ay / mass[i];
+		acceleration[i][2] = az / mass[i];
+	}
+}
+
+//ALLOCATE THE MIXED PRECISION BUFFER
+//Single-precision coordinates used by compute_acc_mixed, exits the program if there is not enough memory
+float* malloc_mixed(size_t Natoms) {
+	float* coord_f = malloc(3 * (Natoms > 0 ? Natoms : 1) * sizeof(float));
+	if (coord_f == NULL) {
+		printf("Error: Not enough memory for the mixed precision kernel\n");
+		exit(-1);
+	}
+	return coord_f;
+}
+
 //UPDATING THE POSITIONS FOR THE VERLET ALGORITHM
 void update_position(size_t Natoms, double** coord, double** velocity, double** acceleration, double** distances, double dt) {
 	for (size_t i = 0; i < Natoms; i++) {
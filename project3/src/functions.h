@@ -8,15 +8,28 @@
 #define SIGMA 0.3345
 #define EPSILON 0.0661
 
+//Cutoff radius of the Lennard-Jones interaction, pairs further apart are skipped. 0.0 means no cutoff,
+//other values can be set at compile time with make CUTOFF=...
+#ifndef CUTOFF
+#define CUTOFF 0.0
+#endif
+
+//Number of atoms whose pair forces the mixed precision kernel sums in single precision before adding them in double
+#define MIXED_BLOCK 64
+
+#include "analysis.h"
+
 double** malloc_2d(size_t m, size_t n);
 void free_2d(double** a);
-size_t read_Natoms(FILE* input_file);
-void read_molecule(FILE* input_file, size_t Natoms, double** coord, double* mass);
+double lj_potential(double r);
+double lj_force(double r);
 void compute_distances(size_t Natoms, double** coord, double** distances);
 double V(size_t Natoms, double** distance);
 double T(size_t Natoms, double** velocity, double* mass);
 double E(size_t Natoms, double** distance, double** velocity, double* mass);
-void compute_acc(size_t Natoms, double** coord, double* mass, double** distance, double** acceleration);
+void compute_acc(size_t Natoms, double** coord, double* mass, double** distance, double** acceleration, Rdf* rdf);
+void compute_acc_mixed(size_t Natoms, double** coord, double* mass, float* coord_f, double** acceleration, Rdf* rdf);
+float* malloc_mixed(size_t Natoms);
 void update_position(size_t Natoms, double** coord, double** velocity, double** acceleration,double** distances, double dt);
 void update_velocity(size_t Natoms, double** coord, double** velocity, double** acceleration, double* mass, double** distances, double dt);
 
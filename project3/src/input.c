@@ -0,0 +1,341 @@
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "functions.h"
+#include "input.h"
+
+//Text files smaller than this are parsed by a single thread
+#define PARALLEL_PARSE_BYTES (1 << 20)
+
+//Powers of ten that are exactly representable as doubles
+static const double pow10_table[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int is_blank(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static int is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+//PARSE A FLOATING POINT NUMBER
+//Locale-free replacement for strtod on [sign]digits[.digits][(e|E)[sign]digits], advances *p past the number.
+//A mantissa below 2^53 scaled by at most 10^22 is converted with a single correctly rounded multiplication or
+//division, which gives the same result as strtod; longer or more extreme numbers fall back to strtod
+static int parse_double(const char** p, const char* end, double* value) {
+	const char* s = *p;
+	const char* start = s;
+	int negative = 0;
+	if (s < end && (*s == '-' || *s == '+')) {
+		negative = (*s == '-');
+		s++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+	int exact = 1;
+	for (; s < end && is_digit(*s); s++, digits++) {
+		if (mantissa >= 900719925474099ULL) {
+			exact = 0;
+		}
+		mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+	}
+	if (s < end && *s == '.') {
+		for (s++; s < end && is_digit(*s); s++, digits++) {
+			if (mantissa >= 900719925474099ULL) {
+				exact = 0;
+			}
+			mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+			exponent--;
+		}
+	}
+	if (digits == 0) {
+		return 0;
+	}
+	if (s < end && (*s == 'e' || *s == 'E')) {
+		s++;
+		int exp_negative = 0;
+		if (s < end && (*s == '-' || *s == '+')) {
+			exp_negative = (*s == '-');
+			s++;
+		}
+		if (s >= end || !is_digit(*s)) {
+			return 0;
+		}
+		int exp_value = 0;
+		for (; s < end && is_digit(*s); s++) {
+			if (exp_value < 10000) {
+				exp_value = exp_value * 10 + (*s - '0');
+			}
+		}
+		exponent += exp_negative ? -exp_value : exp_value;
+	}
+
+	if (exact && exponent >= -22 && exponent <= 22) {
+		double v = (double)mantissa;
+		v = exponent < 0 ? v / pow10_table[-exponent] : v * pow10_table[exponent];
+		*value = negative ? -v : v;
+	}
+	else {
+		//The mapped file is not null terminated, so copy the token before handing it to strtod
+		size_t len = (size_t)(s - start);
+		char small[64];
+		char* buffer = len < sizeof(small) ? small : malloc(len + 1);
+		if (buffer == NULL) {
+			return 0;
+		}
+		memcpy(buffer, start, len);
+		buffer[len] = '\0';
+		*value = strtod(buffer, NULL);
+		if (buffer != small) {
+			free(buffer);
+		}
+	}
+	*p = s;
+	return 1;
+}
+
+static int is_space(char c) {
+	return is_blank(c) || c == '\n';
+}
+
+//PARSE ONE TOKEN
+//Reads the number in the whitespace-separated token starting at *p and advances *p past the token. Tokens that
+//parse_double doesn't read completely (nan, inf, hexadecimal) are handed to strtod like fscanf would; fails if
+//the token is not a number
+static int parse_token(const char** p, const char* end, double* value) {
+	const char* s = *p;
+	if (parse_double(&s, end, value) && (s == end || is_space(*s))) {
+		*p = s;
+		return 1;
+	}
+	s = *p;
+	while (s < end && !is_space(*s)) s++;
+	size_t len = (size_t)(s - *p);
+	char buffer[64];
+	if (len >= sizeof(buffer)) {
+		return 0;
+	}
+	memcpy(buffer, *p, len);
+	buffer[len] = '\0';
+	char* stop;
+	*value = strtod(buffer, &stop);
+	if (stop != buffer + len) {
+		return 0;
+	}
+	*p = s;
+	return 1;
+}
+
+//Skips the whitespace before the next token, returns NULL if there is none before limit
+static const char* next_token(const char* s, const char* limit) {
+	while (s < limit && is_space(*s)) s++;
+	return s < limit ? s : NULL;
+}
+
+//READING A TEXT INPUT FILE
+//As with fscanf, the file is a stream of whitespace-separated tokens: the number of atoms followed by x, y, z and
+//the mass of every atom, regardless of how they are split into lines. The tokens are split in chunks at whitespace,
+//each thread counts the tokens in its chunk and, after a prefix sum gives the index of the first token of every
+//chunk, parses them straight into coord and mass. Returns 1 after printing the error if the file can't be read
+static int read_text_input(const char* data, size_t size, size_t* natoms, double*** coord, double** mass) {
+	const char* end = data + size;
+	const char* s = data;
+
+	//Read the number of atoms from the first token
+	while (s < end && is_space(*s)) s++;
+	if (s == end || !is_digit(*s)) {
+		printf("Error: Not a valid number of atoms\n");
+		return 1;
+	}
+	size_t Natoms = 0;
+	for (; s < end && is_digit(*s); s++) {
+		Natoms = Natoms * 10 + (size_t)(*s - '0');
+	}
+	const char* body = s;
+
+	*coord = malloc_2d(Natoms > 0 ? Natoms : 1, 3);
+	*mass = (double*)malloc((Natoms > 0 ? Natoms : 1) * sizeof(double));
+	if (*coord == NULL || *mass == NULL) {
+		printf("Error: Not enough memory for %zu atoms\n", Natoms);
+		return 1;
+	}
+
+	int nchunks = 1;
+#ifdef _OPENMP
+	if ((size_t)(end - body) > PARALLEL_PARSE_BYTES) {
+		nchunks = omp_get_max_threads();
+	}
+#endif
+	const char** chunk_start = malloc((nchunks + 1) * sizeof(char*));
+	size_t* first_token = malloc((nchunks + 1) * sizeof(size_t));
+	if (chunk_start == NULL || first_token == NULL) {
+		printf("Error: Not enough memory for %zu atoms\n", Natoms);
+		free(chunk_start);
+		free(first_token);
+		return 1;
+	}
+	chunk_start[0] = body;
+	chunk_start[nchunks] = end;
+	for (int t = 1; t < nchunks; t++) {
+		const char* c = body + (size_t)(end - body) * t / nchunks;
+		if (c < chunk_start[t - 1]) {
+			c = chunk_start[t - 1];
+		}
+		while (c < end && !is_space(c[-1])) c++;
+		chunk_start[t] = c;
+	}
+
+	//Count the tokens of every chunk
+	first_token[0] = 0;
+	#pragma omp parallel for num_threads(nchunks) schedule(static, 1)
+	for (int t = 0; t < nchunks; t++) {
+		size_t count = 0;
+		for (const char* c = next_token(chunk_start[t], chunk_start[t + 1]); c != NULL; c = next_token(c, chunk_start[t + 1])) {
+			while (c < end && !is_space(*c)) c++;
+			count++;
+		}
+		first_token[t + 1] = count;
+	}
+	for (int t = 0; t < nchunks; t++) {
+		first_token[t + 1] += first_token[t];
+	}
+
+	//Parse the tokens, token k is column k % 4 of atom k / 4 and tokens after the first Natoms atoms are ignored
+	size_t ntokens = 4 * Natoms;
+	int error = first_token[nchunks] < ntokens;
+	#pragma omp parallel for num_threads(nchunks) schedule(static, 1) reduction(||:error)
+	for (int t = 0; t < nchunks; t++) {
+		size_t k = first_token[t];
+		for (const char* c = next_token(chunk_start[t], chunk_start[t + 1]); c != NULL && k < ntokens && !error; c = next_token(c, chunk_start[t + 1])) {
+			double* target = k % 4 < 3 ? &(*coord)[k / 4][k % 4] : &(*mass)[k / 4];
+			if (!parse_token(&c, end, target)) {
+				error = 1;
+			}
+			k++;
+		}
+	}
+	free(chunk_start);
+	free(first_token);
+
+	//The input file has to hold 4 numbers (coordinates and mass) for every atom
+	if (error) {
+		printf("Error: Couldn't read mass and coordinates\n");
+		return 1;
+	}
+	*natoms = Natoms;
+	return 0;
+}
+
+//READING A BINARY INPUT FILE
+static int read_binary_input(const char* data, size_t size, size_t* natoms, double*** coord, double** mass) {
+	uint64_t Natoms;
+	if (size < BINARY_MAGIC_LEN + sizeof(uint64_t)) {
+		printf("Error: Not a valid number of atoms\n");
+		return 1;
+	}
+	memcpy(&Natoms, data + BINARY_MAGIC_LEN, sizeof(uint64_t));
+	size_t header = BINARY_MAGIC_LEN + sizeof(uint64_t);
+	if (Natoms > (size - header) / (4 * sizeof(double))) {
+		printf("Error: Couldn't read mass and coordinates\n");
+		return 1;
+	}
+
+	*coord = malloc_2d(Natoms > 0 ? Natoms : 1, 3);
+	*mass = (double*)malloc((Natoms > 0 ? Natoms : 1) * sizeof(double));
+	if (*coord == NULL || *mass == NULL) {
+		printf("Error: Not enough memory for %zu atoms\n", (size_t)Natoms);
+		return 1;
+	}
+	memcpy((*coord)[0], data + header, Natoms * 3 * sizeof(double));
+	memcpy(*mass, data + header + Natoms * 3 * sizeof(double), Natoms * sizeof(double));
+	*natoms = Natoms;
+	return 0;
+}
+
+//READING THE INPUT FILE
+//Memory-maps the input file and reads the number of atoms, coordinates and masses from it, either in the text
+//format or in the native binary format. Allocates coord (Natoms x 3) and mass, returns 1 after printing the error
+//(with coord and mass set to NULL) if the file can't be read
+int load_input(const char* path, size_t* Natoms, double*** coord, double** mass) {
+	*coord = NULL;
+	*mass = NULL;
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		printf("Error opening input file\n");
+		if (fd >= 0) {
+			close(fd);
+		}
+		return 1;
+	}
+	size_t size = (size_t)st.st_size;
+	if (size == 0) {
+		printf("Error: Not a valid number of atoms\n");
+		close(fd);
+		return 1;
+	}
+	const char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		printf("Error opening input file\n");
+		return 1;
+	}
+	madvise((void*)data, size, MADV_SEQUENTIAL);
+
+	int error;
+	if (size >= BINARY_MAGIC_LEN && memcmp(data, BINARY_MAGIC, BINARY_MAGIC_LEN) == 0) {
+		error = read_binary_input(data, size, Natoms, coord, mass);
+	}
+	else {
+		error = read_text_input(data, size, Natoms, coord, mass);
+	}
+	munmap((void*)data, size);
+	if (error) {
+		if (*coord != NULL) {
+			free_2d(*coord);
+		}
+		free(*mass);
+		*coord = NULL;
+		*mass = NULL;
+	}
+	return error;
+}
+
+//Same as load_input, but exits the program on errors
+size_t read_input(const char* path, double*** coord, double** mass) {
+	size_t Natoms = 0;
+	if (load_input(path, &Natoms, coord, mass) != 0) {
+		exit(-1);
+	}
+	return Natoms;
+}
+
+//WRITING A BINARY INPUT FILE
+//Writes the atoms in the native binary format read by read_input
+void write_binary_input(const char* path, size_t Natoms, double** coord, double* mass) {
+	FILE* output_file = fopen(path, "wb");
+	if (output_file == NULL) {
+		printf("Error opening output file.\n");
+		exit(-1);
+	}
+	uint64_t n = Natoms;
+	if (fwrite(BINARY_MAGIC, 1, BINARY_MAGIC_LEN, output_file) != BINARY_MAGIC_LEN ||
+	    fwrite(&n, sizeof(uint64_t), 1, output_file) != 1 ||
+	    fwrite(coord[0], sizeof(double), 3 * Natoms, output_file) != 3 * Natoms ||
+	    fwrite(mass, sizeof(double), Natoms, output_file) != Natoms) {
+		printf("Error writing output file.\n");
+		exit(-1);
+	}
+	fclose(output_file);
+}
@@ -0,0 +1,15 @@
+#ifndef INPUT_H
+#define INPUT_H
+#include <stdio.h>
+#include <stdlib.h>
+
+//Magic bytes at the start of a native binary input file, followed by the number of atoms (uint64_t),
+//the coordinates (Natoms x 3 doubles) and the masses (Natoms doubles), all in native byte order
+#define BINARY_MAGIC "MDBIN001"
+#define BINARY_MAGIC_LEN 8
+
+int load_input(const char* path, size_t* Natoms, double*** coord, double** mass);
+size_t read_input(const char* path, double*** coord, double** mass);
+void write_binary_input(const char* path, size_t Natoms, double** coord, double* mass);
+
+#endif
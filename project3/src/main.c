@@ -1,26 +1,66 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <getopt.h>
+#include <errno.h>
+#include <ctype.h>
 #include "functions.h"
+#include "input.h"
+#include "analysis.h"
+#include "validate.h"
+#include "reorder.h"
 
 
 int main(int argc, char* argv[]) {
+	//Read the options selecting the on-the-fly analyses, whether full.out is written and the force kernel
+	int do_rdf = 0, do_msd = 0, do_energy = 0, do_full = 1, mixed = 0, validate = 0;
+	size_t reorder_every = 0;
+	static struct option options[] = {
+		{"rdf", no_argument, NULL, 'r'},
+		{"msd", no_argument, NULL, 'm'},
+		{"energy", no_argument, NULL, 'e'},
+		{"no-full-output", no_argument, NULL, 'n'},
+		{"mixed", no_argument, NULL, 'x'},
+		{"validate-mixed", no_argument, NULL, 'v'},
+		{"reorder", required_argument, NULL, 'o'},
+		{NULL, 0, NULL, 0}
+	};
+	int option;
+	while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+		switch (option) {
+			case 'r': do_rdf = 1; break;
+			case 'm': do_msd = 1; break;
+			case 'e': do_energy = 1; break;
+			case 'n': do_full = 0; break;
+			case 'x': mixed = 1; break;
+			case 'v': validate = 1; break;
+			case 'o': {
+				//Number of steps between reorderings, a non-negative integer (0 disables the reordering). The all-pairs
+				//O(N^2) force kernels read all atoms for every atom, so they don't gain locality from the reordering
+				char* end;
+				errno = 0;
+				reorder_every = strtoul(optarg, &end, 10);
+				if (!isdigit((unsigned char)optarg[0]) || *end != '\0' || errno == ERANGE) {
+					printf("Error: --reorder needs a non-negative number of steps\n");
+					exit(-1);
+				}
+				break;
+			}
+			default: exit(-1);
+		}
+	}
+
 	// Ensure an input file is provided
-	if (argc != 2) {
-		printf("Error: Input file needed as the argument (usage: md_simulation [path_to_input_file)]\n");
+	if (optind != argc - 1) {
+		printf("Error: Input file needed as the argument (usage: md_simulation [--rdf] [--msd] [--energy] [--no-full-output] [--mixed] [--validate-mixed] [--reorder=steps] [path_to_input_file)]\n");
+		printf("--reorder=steps sorts the atoms along a Morton curve every steps steps; the all-pairs O(N^2) force kernels get no speedup from it\n");
 		exit(-1);
 	}
 	
-	//Open the input file
-	FILE* input_file = fopen(argv[1], "r");
-
-	//Read number of atoms and allocate memory for coordinates and masses:
-    	size_t Natoms = read_Natoms(input_file);
-    	double** coord = malloc_2d(Natoms, 3);    	
-    	double* mass = (double*)malloc(Natoms * sizeof(double));
-    
-	//Read coordinates and masses	
-	read_molecule(input_file, Natoms, coord, mass);
+	//Read number of atoms, coordinates and masses (text or binary input file)
+	double** coord;
+	double* mass;
+	size_t Natoms = read_input(argv[optind], &coord, &mass);
 	
 	//Checking if the mass corresponds to an argon atom
 	for(size_t i = 0; i < Natoms; i++) {
@@ -29,9 +69,35 @@ int main(int argc, char* argv[]) {
 			exit(-1);
 		}
 	}
+
+	//Set up simulation parameters, tot_steps = total number of steps, dt = time step, M = output frequency 
+    	double dt = 0.2; 
+    	size_t tot_steps = 1000;
+    	size_t M = 10;
+
+	//Compare the mixed precision force kernel with the double precision one over a reference run and stop
+	if (validate) {
+		int status = validate_mixed(Natoms, coord, mass, dt, tot_steps, M);
+		free_2d(coord);
+		free(mass);
+		return status;
+	}
 	
-	//Close the input file
-    	fclose(input_file);
+	//Sort the atoms along a Morton curve every reorder_every steps, atom_of gives the current position of
+	//every atom of the input file so the output keeps the input order
+	size_t* atom_id = malloc((Natoms > 0 ? Natoms : 1) * sizeof(size_t));
+	size_t* atom_of = malloc((Natoms > 0 ? Natoms : 1) * sizeof(size_t));
+	if (atom_id == NULL || atom_of == NULL) {
+		printf("Error: Not enough memory to reorder the atoms\n");
+		exit(-1);
+	}
+	for (size_t i = 0; i < Natoms; i++) {
+		atom_id[i] = i;
+		atom_of[i] = i;
+	}
+	if (reorder_every > 0) {
+		reorder_atoms(Natoms, coord, NULL, NULL, mass, NULL, atom_id, atom_of);
+	}
 
 	//Allocating the memory for distances between atoms and computing them
     	double** distances = malloc_2d(Natoms, Natoms);
@@ -52,14 +118,35 @@ int main(int argc, char* argv[]) {
     	double kin_E = T(Natoms, velocity, mass);
     	double tot_E = E(Natoms, distances, velocity, mass);
 	
+	//Set up the configured analyses, the radial distribution function is binned by compute_acc
+	Rdf rdf;
+	Msd msd;
+	EnergyStats stats;
+	Rdf* rdf_ptr = NULL;
+	if (do_rdf) {
+		rdf_init(&rdf, CUTOFF > 0.0 && CUTOFF < RDF_RMAX ? CUTOFF : RDF_RMAX, RDF_BINS);
+		rdf_ptr = &rdf;
+	}
+	if (do_msd) {
+		msd_init(&msd, Natoms, coord);
+	}
+	if (do_energy) {
+		energy_stats_init(&stats);
+		energy_stats_sample(&stats, 0.0, kin_E, pot_E, tot_E);
+	}
+
 	//Allocating the memory for acceleration and calculating it
     	double** acceleration = malloc_2d(Natoms, 3); 
-    	compute_acc(Natoms, coord, mass, distances, acceleration);
-
-	//Set up simulation parameters, tot_steps = total number of steps, dt = time step, M = output frequency 
-    	double dt = 0.2; 
-    	size_t tot_steps = 1000;
-    	size_t M = 10;
+	float* coord_f = mixed ? malloc_mixed(Natoms) : NULL;
+	if (mixed) {
+		compute_acc_mixed(Natoms, coord, mass, coord_f, acceleration, rdf_ptr);
+	}
+	else {
+    		compute_acc(Natoms, coord, mass, distances, acceleration, rdf_ptr);
+	}
+	if (do_rdf) {
+		rdf_sample(&rdf, Natoms, coord);
+	}
 
 	// Open the output files (trajectory.xyz and full.out) and check if they opened correctly
     	FILE* output_file = fopen("trajectory.xyz", "w");
@@ -67,35 +154,38 @@ int main(int argc, char* argv[]) {
         	printf("Error opening output file.\n");
         	exit(-1);
     	}
-    	FILE* full_output = fopen("full.out", "w");
-    	if (full_output == NULL) {
-        	printf("Error opening full output file.\n");
-        	exit(-1);
-    	}
+    	FILE* full_output = NULL;
+	if (do_full) {
+	    	full_output = fopen("full.out", "w");
+	    	if (full_output == NULL) {
+	        	printf("Error opening full output file.\n");
+	        	exit(-1);
+	    	}
 
-	//Write initial conditions and energies to full.out
-    	fprintf(full_output, "Initial Setup:\n");
-	fprintf(full_output, "Energies: Potential = %.6f, Kinetic = %.6f, Total = %.6f\n", pot_E, kin_E, tot_E);
-    	fprintf(full_output, "Number of atoms: %zu\n", Natoms);
-    	fprintf(full_output, "Atom type: %s\n", ATOM_TYPE);
-    	fprintf(full_output, "Sigma: %.4f, Epsilon: %.4f\n", SIGMA, EPSILON);
-    	fprintf(full_output, "Coordinates and masses:\n");
-    	for (size_t i = 0; i < Natoms; i++) {
-        	fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f, Mass: %.5f\n", i + 1, ATOM_TYPE, coord[i][0], coord[i][1], coord[i][2], mass[i]);
-    	}
-	fprintf(full_output, "Distances:\n");
-		for (size_t i = 0; i < Natoms; i++) {
-                	for (size_t j = i+1; j < Natoms; j++) {
-                        	fprintf(full_output, "Atom %zu (%s) - Atoms %zu (%s): %.5f\n",i+1, ATOM_TYPE, j+1, ATOM_TYPE, distances[i][j]);
-                        }
-                 }
-	fprintf(full_output, "\n");
+		//Write initial conditions and energies to full.out
+	    	fprintf(full_output, "Initial Setup:\n");
+		fprintf(full_output, "Energies: Potential = %.6f, Kinetic = %.6f, Total = %.6f\n", pot_E, kin_E, tot_E);
+	    	fprintf(full_output, "Number of atoms: %zu\n", Natoms);
+	    	fprintf(full_output, "Atom type: %s\n", ATOM_TYPE);
+	    	fprintf(full_output, "Sigma: %.4f, Epsilon: %.4f\n", SIGMA, EPSILON);
+	    	fprintf(full_output, "Coordinates and masses:\n");
+	    	for (size_t i = 0; i < Natoms; i++) {
+	        	fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f, Mass: %.5f\n", i + 1, ATOM_TYPE, coord[atom_of[i]][0], coord[atom_of[i]][1], coord[atom_of[i]][2], mass[atom_of[i]]);
+	    	}
+		fprintf(full_output, "Distances:\n");
+			for (size_t i = 0; i < Natoms; i++) {
+	                	for (size_t j = i+1; j < Natoms; j++) {
+	                        	fprintf(full_output, "Atom %zu (%s) - Atoms %zu (%s): %.5f\n",i+1, ATOM_TYPE, j+1, ATOM_TYPE, distances[atom_of[i]][atom_of[j]]);
+	                        }
+	                 }
+		fprintf(full_output, "\n");
+	}
 
 	//Write intial configuration to trajectory.xyz
     	fprintf(output_file, "%zu\n", Natoms);
     	fprintf(output_file, "#Potential energy = %.6f, Kinetic energy = %.6f, Total energy = %.6f \n", pot_E, kin_E, tot_E);	
     	for (size_t i = 0; i < Natoms; i++) {
-        	fprintf(output_file, "%s %.5f, %.5f, %.5f\n", ATOM_TYPE,  coord[i][0], coord[i][1], coord[i][2]);
+        	fprintf(output_file, "%s %.5f, %.5f, %.5f\n", ATOM_TYPE,  coord[atom_of[i]][0], coord[atom_of[i]][1], coord[atom_of[i]][2]);
     	}
     
 	//Store previous energy for difference calculation
@@ -104,10 +194,24 @@ int main(int argc, char* argv[]) {
 //MAIN SIMULATION LOOP (VERLET ALGORITHM)
 	//Update postitions, distances, velocities and accelerations	
     	for (size_t step = 1; step <= tot_steps; step++){
+		if (reorder_every > 0 && step % reorder_every == 0) {
+			reorder_atoms(Natoms, coord, velocity, acceleration, mass, do_msd ? msd.reference : NULL, atom_id, atom_of);
+		}
         	update_position(Natoms, coord, velocity, acceleration, distances, dt);
-        	compute_distances(Natoms, coord, distances);
+		//The mixed precision kernel doesn't use the distances, they are only needed for the output
+		if (!mixed || step % M == 0) {
+        		compute_distances(Natoms, coord, distances);
+		}
         	update_velocity(Natoms, coord, velocity, acceleration, mass, distances, dt);
-        	compute_acc(Natoms, coord, mass, distances, acceleration);
+		if (mixed) {
+			compute_acc_mixed(Natoms, coord, mass, coord_f, acceleration, rdf_ptr);
+		}
+		else {
+        		compute_acc(Natoms, coord, mass, distances, acceleration, rdf_ptr);
+		}
+		if (do_rdf) {
+			rdf_sample(&rdf, Natoms, coord);
+		}
         	update_velocity(Natoms, coord, velocity, acceleration, mass, distances, dt);
 
 		//Every M steps update the energies and write the number of atoms, energies and coordinates to trajectory.xyz and atoms, energies, coordinates, velociites and accelerations to full.out
@@ -120,39 +224,61 @@ int main(int argc, char* argv[]) {
             		fprintf(output_file, "%zu\n", Natoms);
             		fprintf(output_file, "#Step %zu: Potential energy = %.6f, Kinetic energy = %.6f, Total energy = %.6f, Energy difference = %.6f \n",step, pot_E, kin_E, tot_E, dE);
             		for (size_t i = 0; i < Natoms; i++) {
-                		fprintf(output_file, "%s %.5f, %.5f, %.5f\n", ATOM_TYPE,  coord[i][0], coord[i][1], coord[i][2]);
+                		fprintf(output_file, "%s %.5f, %.5f, %.5f\n", ATOM_TYPE,  coord[atom_of[i]][0], coord[atom_of[i]][1], coord[atom_of[i]][2]);
             		}
-            
-            		fprintf(full_output, "Step %zu:\n", step);
-           		fprintf(full_output, "Energies: Potential = %.6f, Kinetic = %.6f, Total = %.6f, Energy Difference = %.6f\n", pot_E, kin_E, tot_E, dE);
-            		fprintf(full_output, "Coordinates:\n");
-            		for (size_t i = 0; i < Natoms; i++) {
-                		fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, coord[i][0], coord[i][1], coord[i][2]);
-            		}
-			fprintf(full_output, "Distances:\n");
-                        for (size_t i = 0; i < Natoms; i++) {
-                                for (size_t j = i+1; j < Natoms; j++) {
-                                        fprintf(full_output, "Atom %zu (%s) - Atoms %zu (%s): %.5f\n",i+1, ATOM_TYPE, j+1, ATOM_TYPE, distances[i][j]);
-                                }
-                        }
-            		fprintf(full_output, "Velocities:\n");
-            		for (size_t i = 0; i < Natoms; i++) {
-                		fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, velocity[i][0], velocity[i][1], velocity[i][2]);
-            		}
-            		fprintf(full_output, "Accelerations:\n");
-            		for (size_t i = 0; i < Natoms; i++) {
-                		fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, acceleration[i][0], acceleration[i][1], acceleration[i][2]);
-            		}
-            		fprintf(full_output, "\n");
+
+			if (do_energy) {
+				energy_stats_sample(&stats, step * dt, kin_E, pot_E, tot_E);
+			}
+			if (do_msd) {
+				msd_sample(&msd, step, Natoms, coord);
+			}
+
+			if (do_full) {
+	            		fprintf(full_output, "Step %zu:\n", step);
+	           		fprintf(full_output, "Energies: Potential = %.6f, Kinetic = %.6f, Total = %.6f, Energy Difference = %.6f\n", pot_E, kin_E, tot_E, dE);
+	            		fprintf(full_output, "Coordinates:\n");
+	            		for (size_t i = 0; i < Natoms; i++) {
+	                		fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, coord[atom_of[i]][0], coord[atom_of[i]][1], coord[atom_of[i]][2]);
+	            		}
+				fprintf(full_output, "Distances:\n");
+	                        for (size_t i = 0; i < Natoms; i++) {
+	                                for (size_t j = i+1; j < Natoms; j++) {
+	                                        fprintf(full_output, "Atom %zu (%s) - Atoms %zu (%s): %.5f\n",i+1, ATOM_TYPE, j+1, ATOM_TYPE, distances[atom_of[i]][atom_of[j]]);
+	                                }
+	                        }
+	            		fprintf(full_output, "Velocities:\n");
+	            		for (size_t i = 0; i < Natoms; i++) {
+	                		fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, velocity[atom_of[i]][0], velocity[atom_of[i]][1], velocity[atom_of[i]][2]);
+	            		}
+	            		fprintf(full_output, "Accelerations:\n");
+	            		for (size_t i = 0; i < Natoms; i++) {
+	                		fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, acceleration[atom_of[i]][0], acceleration[atom_of[i]][1], acceleration[atom_of[i]][2]);
+	            		}
+	            		fprintf(full_output, "\n");
+			}
 	            	
 			//Update previous energy for next step
 			prev_E = tot_E;
         	}
     	}
 
-//Close the output files
+//Close the output files and write the analysis summaries
     	fclose(output_file);
-    	fclose(full_output);
+	if (do_full) {
+	    	fclose(full_output);
+	}
+	if (do_rdf) {
+		rdf_write(&rdf, "rdf.dat", Natoms);
+		rdf_free(&rdf);
+	}
+	if (do_msd) {
+		msd_write(&msd, "msd.dat", dt);
+		msd_free(&msd);
+	}
+	if (do_energy) {
+		energy_stats_write(&stats, "energy.dat");
+	}
 
 
 // Free the allocated memory
@@ -161,6 +287,9 @@ int main(int argc, char* argv[]) {
     	free_2d(distances);
     	free_2d(velocity);
     	free_2d(acceleration);
+	free(coord_f);
+	free(atom_id);
+	free(atom_of);
     	coord = NULL;
     	mass = NULL;
     	distances = NULL;
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <mpi.h>
+#include "functions.h"
+#include "input.h"
+#include "domain.h"
+
+//Writes the distances between all pairs of atoms to full.out, computed from the coordinates on the fly
+static void write_distances(FILE* full_output, size_t Natoms, double** coord) {
+	fprintf(full_output, "Distances:\n");
+	for (size_t i = 0; i < Natoms; i++) {
+		for (size_t j = i+1; j < Natoms; j++) {
+			double dx = coord[i][0] - coord[j][0];
+			double dy = coord[i][1] - coord[j][1];
+			double dz = coord[i][2] - coord[j][2];
+			fprintf(full_output, "Atom %zu (%s) - Atoms %zu (%s): %.5f\n",i+1, ATOM_TYPE, j+1, ATOM_TYPE, sqrt(dx * dx + dy * dy + dz * dz));
+		}
+	}
+}
+
+//Domain-decomposed version of md_simulation: every rank integrates the atoms in its slab of the cell,
+//rank 0 reads the input and writes the same trajectory.xyz and full.out as the serial program
+int main(int argc, char* argv[]) {
+	MPI_Init(&argc, &argv);
+	int rank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	// Ensure an input file is provided
+	if (argc != 2) {
+		if (rank == 0) {
+			printf("Error: Input file needed as the argument (usage: mpirun -np N md_simulation_mpi [path_to_input_file)]\n");
+		}
+		MPI_Abort(MPI_COMM_WORLD, -1);
+	}
+
+	//Rank 0 reads the input file and checks the masses, the other ranks only get the number of atoms.
+	//Errors abort all ranks, since the other ranks are already waiting in MPI_Bcast
+	double** coord = NULL;
+	double* mass = NULL;
+	double** velocity = NULL;
+	double** acceleration = NULL;
+	unsigned long long n = 0;
+	if (rank == 0) {
+		size_t Natoms_read = 0;
+		if (load_input(argv[1], &Natoms_read, &coord, &mass) != 0) {
+			MPI_Abort(MPI_COMM_WORLD, -1);
+		}
+		n = Natoms_read;
+		for (size_t i = 0; i < n; i++) {
+			if (mass[i] != 39.948) {
+				printf("Error: Properties of atoms other than argon (mass = 39.948) aren't implemented\n");
+				MPI_Abort(MPI_COMM_WORLD, -1);
+			}
+		}
+		velocity = malloc_2d(n > 0 ? n : 1, 3);
+		acceleration = malloc_2d(n > 0 ? n : 1, 3);
+		if (velocity == NULL || acceleration == NULL) {
+			printf("Error: Not enough memory for %zu atoms\n", (size_t)n);
+			MPI_Abort(MPI_COMM_WORLD, -1);
+		}
+	}
+	MPI_Bcast(&n, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+	size_t Natoms = (size_t)n;
+
+	//Distribute the atoms over the ranks, compute the energies and accelerations of the initial configuration
+	Domain dom;
+	domain_init(&dom, MPI_COMM_WORLD, Natoms, coord, mass);
+	domain_exchange_halo(&dom);
+	double kin_E, pot_E;
+	domain_energies(&dom, &kin_E, &pot_E);
+	double tot_E = kin_E + pot_E;
+	domain_compute_acc(&dom);
+
+	//Set up simulation parameters, tot_steps = total number of steps, dt = time step, M = output frequency
+	double dt = 0.2;
+	size_t tot_steps = 1000;
+	size_t M = 10;
+
+	//Open the output files and write the initial conditions
+	FILE* output_file = NULL;
+	FILE* full_output = NULL;
+	if (rank == 0) {
+		output_file = fopen("trajectory.xyz", "w");
+		full_output = fopen("full.out", "w");
+		if (output_file == NULL || full_output == NULL) {
+			printf("Error opening output file.\n");
+			MPI_Abort(MPI_COMM_WORLD, -1);
+		}
+
+		fprintf(full_output, "Initial Setup:\n");
+		fprintf(full_output, "Energies: Potential = %.6f, Kinetic = %.6f, Total = %.6f\n", pot_E, kin_E, tot_E);
+		fprintf(full_output, "Number of atoms: %zu\n", Natoms);
+		fprintf(full_output, "Atom type: %s\n", ATOM_TYPE);
+		fprintf(full_output, "Sigma: %.4f, Epsilon: %.4f\n", SIGMA, EPSILON);
+		fprintf(full_output, "Coordinates and masses:\n");
+		for (size_t i = 0; i < Natoms; i++) {
+			fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f, Mass: %.5f\n", i + 1, ATOM_TYPE, coord[i][0], coord[i][1], coord[i][2], mass[i]);
+		}
+		write_distances(full_output, Natoms, coord);
+		fprintf(full_output, "\n");
+
+		fprintf(output_file, "%zu\n", Natoms);
+		fprintf(output_file, "#Potential energy = %.6f, Kinetic energy = %.6f, Total energy = %.6f \n", pot_E, kin_E, tot_E);
+		for (size_t i = 0; i < Natoms; i++) {
+			fprintf(output_file, "%s %.5f, %.5f, %.5f\n", ATOM_TYPE,  coord[i][0], coord[i][1], coord[i][2]);
+		}
+	}
+
+	//Store previous energy for difference calculation
+	double prev_E = tot_E;
+
+//MAIN SIMULATION LOOP (VERLET ALGORITHM)
+	//Update positions and velocities of the owned atoms, move atoms that left their slab to the new owner,
+	//refresh the halo and compute the new accelerations
+	for (size_t step = 1; step <= tot_steps; step++) {
+		domain_update_position(&dom, dt);
+		domain_update_velocity(&dom, dt);
+		domain_migrate(&dom);
+		domain_exchange_halo(&dom);
+		domain_compute_acc(&dom);
+		domain_update_velocity(&dom, dt);
+
+		//Every M steps reduce the energies and write the gathered atoms from rank 0
+		if (step % M == 0) {
+			domain_energies(&dom, &kin_E, &pot_E);
+			tot_E = kin_E + pot_E;
+			double dE = tot_E - prev_E;
+			domain_gather(&dom, Natoms, coord, velocity, acceleration);
+
+			if (rank == 0) {
+				fprintf(output_file, "%zu\n", Natoms);
+				fprintf(output_file, "#Step %zu: Potential energy = %.6f, Kinetic energy = %.6f, Total energy = %.6f, Energy difference = %.6f \n",step, pot_E, kin_E, tot_E, dE);
+				for (size_t i = 0; i < Natoms; i++) {
+					fprintf(output_file, "%s %.5f, %.5f, %.5f\n", ATOM_TYPE,  coord[i][0], coord[i][1], coord[i][2]);
+				}
+
+				fprintf(full_output, "Step %zu:\n", step);
+				fprintf(full_output, "Energies: Potential = %.6f, Kinetic = %.6f, Total = %.6f, Energy Difference = %.6f\n", pot_E, kin_E, tot_E, dE);
+				fprintf(full_output, "Coordinates:\n");
+				for (size_t i = 0; i < Natoms; i++) {
+					fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, coord[i][0], coord[i][1], coord[i][2]);
+				}
+				write_distances(full_output, Natoms, coord);
+				fprintf(full_output, "Velocities:\n");
+				for (size_t i = 0; i < Natoms; i++) {
+					fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, velocity[i][0], velocity[i][1], velocity[i][2]);
+				}
+				fprintf(full_output, "Accelerations:\n");
+				for (size_t i = 0; i < Natoms; i++) {
+					fprintf(full_output, "Atom %zu (%s): %.5f %.5f %.5f\n", i + 1, ATOM_TYPE, acceleration[i][0], acceleration[i][1], acceleration[i][2]);
+				}
+				fprintf(full_output, "\n");
+			}
+
+			//Update previous energy for next step
+			prev_E = tot_E;
+		}
+	}
+
+//Close the output files and free the allocated memory
+	if (rank == 0) {
+		fclose(output_file);
+		fclose(full_output);
+		free_2d(coord);
+		free(mass);
+		free_2d(velocity);
+		free_2d(acceleration);
+		printf("MD simulation complete.\n");
+	}
+	domain_free(&dom);
+
+	MPI_Finalize();
+	return 0;
+}
@@ -0,0 +1,22 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "functions.h"
+#include "input.h"
+
+//Converts an input file (text or binary) to the native binary input format
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		printf("Error: Input and output file needed as the arguments (usage: md_convert [path_to_input_file] [path_to_binary_file])\n");
+		exit(-1);
+	}
+
+	double** coord;
+	double* mass;
+	size_t Natoms = read_input(argv[1], &coord, &mass);
+	write_binary_input(argv[2], Natoms, coord, mass);
+
+	free_2d(coord);
+	free(mass);
+	printf("Converted %zu atoms to %s\n", Natoms, argv[2]);
+	return 0;
+}
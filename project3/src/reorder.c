@@ -0,0 +1,120 @@
+#include <string.h>
+#include "functions.h"
+#include "reorder.h"
+
+typedef struct {
+	uint64_t key;
+	size_t index;
+} MortonEntry;
+
+//Spreads the lower 21 bits of v so that there are two zero bits between consecutive bits
+static uint64_t spread_bits(uint64_t v) {
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffULL;
+	v = (v | v << 16) & 0x1f0000ff0000ffULL;
+	v = (v | v << 8) & 0x100f00f00f00f00fULL;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+	v = (v | v << 2) & 0x1249249249249249ULL;
+	return v;
+}
+
+//MORTON KEY
+//Interleaves the bits of the integer cell coordinates x, y and z
+static uint64_t morton_key(uint32_t x, uint32_t y, uint32_t z) {
+	return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+}
+
+static int compare_entries(const void* a, const void* b) {
+	const MortonEntry* x = a;
+	const MortonEntry* y = b;
+	if (x->key != y->key) {
+		return x->key < y->key ? -1 : 1;
+	}
+	return (x->index > y->index) - (x->index < y->index);
+}
+
+//ORDERING THE ATOMS ALONG A MORTON CURVE
+//Divides the bounding box of the atoms in 2^21 cells per dimension and sorts the atoms by the Morton key of their
+//cell, so atoms that are close in space end up close in memory. order[k] is the current index of the k-th atom
+void morton_order(size_t Natoms, double** coord, size_t* order) {
+	if (Natoms == 0) {
+		return;
+	}
+	double lo[3], scale[3];
+	for (size_t d = 0; d < 3; d++) {
+		lo[d] = coord[0][d];
+		double hi = coord[0][d];
+		for (size_t i = 1; i < Natoms; i++) {
+			if (coord[i][d] < lo[d]) lo[d] = coord[i][d];
+			if (coord[i][d] > hi) hi = coord[i][d];
+		}
+		scale[d] = hi > lo[d] ? ((1 << MORTON_BITS) - 1) / (hi - lo[d]) : 0.0;
+	}
+
+	MortonEntry* entries = malloc(Natoms * sizeof(MortonEntry));
+	if (entries == NULL) {
+		printf("Error: Not enough memory to reorder the atoms\n");
+		exit(-1);
+	}
+	for (size_t i = 0; i < Natoms; i++) {
+		uint32_t cell[3];
+		for (size_t d = 0; d < 3; d++) {
+			cell[d] = (uint32_t)((coord[i][d] - lo[d]) * scale[d]);
+		}
+		entries[i].key = morton_key(cell[0], cell[1], cell[2]);
+		entries[i].index = i;
+	}
+	qsort(entries, Natoms, sizeof(MortonEntry), compare_entries);
+	for (size_t k = 0; k < Natoms; k++) {
+		order[k] = entries[k].index;
+	}
+	free(entries);
+}
+
+//Moves row order[k] of the Natoms x 3 array a to row k
+static void permute_rows(size_t Natoms, const size_t* order, double** a, double* scratch) {
+	for (size_t k = 0; k < Natoms; k++) {
+		memcpy(scratch + 3 * k, a[order[k]], 3 * sizeof(double));
+	}
+	memcpy(a[0], scratch, 3 * Natoms * sizeof(double));
+}
+
+//REORDERING THE ATOMS
+//Sorts all per-atom arrays along the Morton curve. velocity, acceleration and reference (the MSD starting
+//coordinates) may be NULL if they are not allocated yet.
+//atom_id[k] is the input file index of the atom stored at position k and atom_of is its inverse, so the
+//output can still be written in input order
+void reorder_atoms(size_t Natoms, double** coord, double** velocity, double** acceleration, double* mass, double** reference, size_t* atom_id, size_t* atom_of) {
+	size_t* order = malloc((Natoms > 0 ? Natoms : 1) * sizeof(size_t));
+	double* scratch = malloc(3 * (Natoms > 0 ? Natoms : 1) * sizeof(double));
+	size_t* ids = malloc((Natoms > 0 ? Natoms : 1) * sizeof(size_t));
+	if (order == NULL || scratch == NULL || ids == NULL) {
+		printf("Error: Not enough memory to reorder the atoms\n");
+		exit(-1);
+	}
+	morton_order(Natoms, coord, order);
+
+	permute_rows(Natoms, order, coord, scratch);
+	if (velocity != NULL) {
+		permute_rows(Natoms, order, velocity, scratch);
+	}
+	if (acceleration != NULL) {
+		permute_rows(Natoms, order, acceleration, scratch);
+	}
+	if (reference != NULL) {
+		permute_rows(Natoms, order, reference, scratch);
+	}
+	for (size_t k = 0; k < Natoms; k++) {
+		scratch[k] = mass[order[k]];
+		ids[k] = atom_id[order[k]];
+	}
+	memcpy(mass, scratch, Natoms * sizeof(double));
+	memcpy(atom_id, ids, Natoms * sizeof(size_t));
+	for (size_t k = 0; k < Natoms; k++) {
+		atom_of[atom_id[k]] = k;
+	}
+
+	free(ids);
+	free(scratch);
+	free(order);
+}
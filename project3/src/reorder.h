@@ -0,0 +1,13 @@
+#ifndef REORDER_H
+#define REORDER_H
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+//Bits per dimension of the Morton keys (3 x 21 bits fit in 64 bits)
+#define MORTON_BITS 21
+
+void morton_order(size_t Natoms, double** coord, size_t* order);
+void reorder_atoms(size_t Natoms, double** coord, double** velocity, double** acceleration, double* mass, double** reference, size_t* atom_id, size_t* atom_of);
+
+#endif
@@ -0,0 +1,181 @@
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include "functions.h"
+#include "validate.h"
+
+//Largest deviation of the acceleration vectors a from the reference ref. Every component is taken relative to the
+//sum over the pairs of the atom (same cutoff as compute_acc) of the magnitudes of the repulsive and attractive
+//accelerations. This is the scale of the rounding errors of the single-precision pair forces, which can be much
+//larger than the net force where the two terms or the pairs cancel
+static double force_error(size_t Natoms, double** coord, double* mass, double** a, double** ref) {
+	double max_error = 0.0;
+	for (size_t i = 0; i < Natoms; i++) {
+		double scale = 0.0;
+		for (size_t j = 0; j < Natoms; j++) {
+			if (i == j) continue;
+			double dx = coord[i][0] - coord[j][0];
+			double dy = coord[i][1] - coord[j][1];
+			double dz = coord[i][2] - coord[j][2];
+			double r = sqrt(dx * dx + dy * dy + dz * dz);
+			if (CUTOFF > 0.0 && r > CUTOFF) continue;
+			double s_r_6 = pow(SIGMA / r, 6);
+			scale += 24 * EPSILON * (s_r_6 + 2 * s_r_6 * s_r_6) / (r * mass[i]);
+		}
+		for (size_t d = 0; d < 3; d++) {
+			double diff = fabs(a[i][d] - ref[i][d]);
+			double error = scale > 0.0 ? diff / scale : diff;
+			if (error > max_error) max_error = error;
+		}
+	}
+	return max_error;
+}
+
+//Moves every coordinate by a pseudo-random amount in [-amplitude, amplitude), the same for the same seed
+static void perturb(size_t Natoms, double** coord, double amplitude, uint64_t seed) {
+	uint64_t state = seed;
+	for (size_t k = 0; k < 3 * Natoms; k++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		double u = (state >> 11) * (1.0 / 9007199254740992.0);
+		coord[0][k] += amplitude * (2.0 * u - 1.0);
+	}
+}
+
+//Largest extent of the bounding box of the atoms
+static double box_extent(size_t Natoms, double** coord) {
+	double extent = 0.0;
+	for (size_t d = 0; d < 3 && Natoms > 0; d++) {
+		double lo = coord[0][d];
+		double hi = coord[0][d];
+		for (size_t i = 1; i < Natoms; i++) {
+			if (coord[i][d] < lo) lo = coord[i][d];
+			if (coord[i][d] > hi) hi = coord[i][d];
+		}
+		if (hi - lo > extent) extent = hi - lo;
+	}
+	return extent;
+}
+
+//ONE VALIDATION RUN
+//Verlet integration over tot_steps from the input configuration with every coordinate perturbed by up to
+//perturbation, with compute_acc_mixed if mixed and with compute_acc otherwise. The total energy is sampled every M
+//steps; the energy drift is the slope of the least-squares fit of E(t) times the length of the run, relative to
+//the initial energy. If max_force_error is not NULL (double precision runs), the mixed precision accelerations are
+//also computed on the trajectory every M steps and the largest deviation from the double precision ones is stored
+//in *max_force_error. Returns the energy drift
+static double validation_run(size_t Natoms, double** coord0, double* mass, double dt, size_t tot_steps, size_t M, int mixed,
+                             double perturbation, uint64_t seed, double* max_force_error) {
+	double** coord = malloc_2d(Natoms, 3);
+	double** velocity = malloc_2d(Natoms, 3);
+	double** acceleration = malloc_2d(Natoms, 3);
+	double** acceleration_check = malloc_2d(Natoms, 3);
+	double** distances = malloc_2d(Natoms, Natoms);
+	float* coord_f = malloc_mixed(Natoms);
+	if (coord == NULL || velocity == NULL || acceleration == NULL || acceleration_check == NULL || distances == NULL) {
+		printf("Error: Not enough memory for the validation run\n");
+		exit(-1);
+	}
+	memcpy(coord[0], coord0[0], 3 * Natoms * sizeof(double));
+	memset(velocity[0], 0, 3 * Natoms * sizeof(double));
+	if (perturbation > 0.0) {
+		perturb(Natoms, coord, perturbation, seed);
+	}
+
+	compute_distances(Natoms, coord, distances);
+	double E0 = E(Natoms, distances, velocity, mass);
+	EnergyStats stats;
+	energy_stats_init(&stats);
+	energy_stats_sample(&stats, 0.0, 0.0, E0, E0);
+	if (mixed) {
+		compute_acc_mixed(Natoms, coord, mass, coord_f, acceleration, NULL);
+	}
+	else {
+		compute_acc(Natoms, coord, mass, distances, acceleration, NULL);
+	}
+	if (max_force_error != NULL) {
+		compute_acc_mixed(Natoms, coord, mass, coord_f, acceleration_check, NULL);
+		*max_force_error = force_error(Natoms, coord, mass, acceleration_check, acceleration);
+	}
+
+	for (size_t step = 1; step <= tot_steps; step++) {
+		update_position(Natoms, coord, velocity, acceleration, distances, dt);
+		//The mixed precision kernel doesn't use the distances, they are only needed for the energies
+		if (!mixed || step % M == 0) {
+			compute_distances(Natoms, coord, distances);
+		}
+		update_velocity(Natoms, coord, velocity, acceleration, mass, distances, dt);
+		if (mixed) {
+			compute_acc_mixed(Natoms, coord, mass, coord_f, acceleration, NULL);
+		}
+		else {
+			compute_acc(Natoms, coord, mass, distances, acceleration, NULL);
+		}
+		update_velocity(Natoms, coord, velocity, acceleration, mass, distances, dt);
+
+		if (step % M == 0) {
+			if (max_force_error != NULL) {
+				compute_acc_mixed(Natoms, coord, mass, coord_f, acceleration_check, NULL);
+				double error = force_error(Natoms, coord, mass, acceleration_check, acceleration);
+				if (error > *max_force_error) *max_force_error = error;
+			}
+			double kin_E = T(Natoms, velocity, mass);
+			double pot_E = V(Natoms, distances);
+			energy_stats_sample(&stats, step * dt, kin_E, pot_E, kin_E + pot_E);
+		}
+	}
+
+	free_2d(coord);
+	free_2d(velocity);
+	free_2d(acceleration);
+	free_2d(acceleration_check);
+	free_2d(distances);
+	free(coord_f);
+	double scale = tot_steps * dt / (E0 != 0.0 ? fabs(E0) : 1.0);
+	return stats.m2_t > 0.0 ? stats.cov_tE / stats.m2_t * scale : 0.0;
+}
+
+//VALIDATING THE MIXED PRECISION KERNEL
+//The main test is the force error: the mixed precision accelerations are compared with the double precision ones
+//every M steps along the double precision trajectory. The trajectories of both kernels separate after some steps,
+//so their energy drifts are not compared with a fixed margin. Instead the drift of the mixed precision run is
+//compared with the distribution of the drift over the unperturbed and MIXED_DRIFT_RUNS perturbed double precision
+//runs, whose positions differ by the rounding of the coordinates to float (FLT_EPSILON times the size of the box).
+//Small systems barely spread, so a difference of MIXED_DRIFT_PER_STEP times the number of steps is always accepted.
+//This bound doesn't grow with the drift of the double precision runs.
+//Prints a report and returns 0 if both tests pass, -1 otherwise
+int validate_mixed(size_t Natoms, double** coord, double* mass, double dt, size_t tot_steps, size_t M) {
+	double max_force_error = 0.0;
+	double drift_d = validation_run(Natoms, coord, mass, dt, tot_steps, M, 0, 0.0, 0, &max_force_error);
+	double drift_m = validation_run(Natoms, coord, mass, dt, tot_steps, M, 1, 0.0, 0, NULL);
+
+	//Mean and standard deviation of the double precision drift
+	double extent = box_extent(Natoms, coord);
+	double perturbation = FLT_EPSILON * (extent > 0.0 ? extent : SIGMA);
+	double drift[MIXED_DRIFT_RUNS + 1];
+	double mean = drift[0] = drift_d;
+	for (int run = 1; run <= MIXED_DRIFT_RUNS; run++) {
+		drift[run] = validation_run(Natoms, coord, mass, dt, tot_steps, M, 0, perturbation, run, NULL);
+		mean += drift[run];
+	}
+	mean /= MIXED_DRIFT_RUNS + 1;
+	double variance = 0.0;
+	for (int run = 0; run <= MIXED_DRIFT_RUNS; run++) {
+		variance += (drift[run] - mean) * (drift[run] - mean);
+	}
+	double deviation = sqrt(variance / MIXED_DRIFT_RUNS);
+
+	int force_passed = max_force_error <= MIXED_FORCE_TOLERANCE;
+	double accepted = MIXED_DRIFT_FACTOR * deviation;
+	if (MIXED_DRIFT_PER_STEP * tot_steps > accepted) accepted = MIXED_DRIFT_PER_STEP * tot_steps;
+	int drift_passed = fabs(drift_m - mean) <= accepted;
+
+	printf("Mixed precision validation over %zu steps:\n", tot_steps);
+	printf("Maximum force error (relative to the pair forces of the atom): %.3e (tolerance %.1e): %s\n", max_force_error,
+	       MIXED_FORCE_TOLERANCE, force_passed ? "passed" : "failed");
+	printf("Relative energy drift: mixed = %.3e, double = %.3e, mean = %.3e and standard deviation = %.3e over %d runs perturbed by %.1e nm\n",
+	       drift_m, drift_d, mean, deviation, MIXED_DRIFT_RUNS + 1, perturbation);
+	printf("Deviation of the mixed precision drift from the mean: %.3e (tolerance %.3e, the larger of %.1f standard deviations and %.0e per step): %s\n",
+	       fabs(drift_m - mean), accepted, MIXED_DRIFT_FACTOR, MIXED_DRIFT_PER_STEP, drift_passed ? "passed" : "failed");
+	printf("%s\n", force_passed && drift_passed ? "Validation passed" : "Validation failed");
+	return force_passed && drift_passed ? 0 : -1;
+}
@@ -0,0 +1,19 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+#include <stdio.h>
+#include <stdlib.h>
+
+//Largest accepted force error of the mixed precision kernel, relative to the sum of the magnitudes of the pair
+//forces on the atom
+#define MIXED_FORCE_TOLERANCE 1e-4
+//The energy drift is compared with MIXED_DRIFT_RUNS double precision runs from positions perturbed by the rounding
+//of the coordinates to float: the mixed precision drift may differ from their mean by at most MIXED_DRIFT_FACTOR
+//standard deviations, or by MIXED_DRIFT_PER_STEP (relative to the initial energy) per step for systems that are
+//not chaotic enough to spread
+#define MIXED_DRIFT_RUNS 5
+#define MIXED_DRIFT_FACTOR 5.0
+#define MIXED_DRIFT_PER_STEP 1e-9
+
+int validate_mixed(size_t Natoms, double** coord, double* mass, double dt, size_t tot_steps, size_t M);
+
+#endif